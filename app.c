@@ -2,12 +2,19 @@
 // Giovana Nogueira 2220372    
    
 #include "common.h"
+#include "kaio.h"
+#include "msgring.h"
+#include "park.h"
+#include "work.h"
+#include "workload.h"
+#include "zygote.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
 #include <string.h>
 #include <time.h>
+#include <getopt.h>
 
 // Define descritor de escrita para o pipe app->kernel
 // e outras variáveis de identificação do processo
@@ -15,59 +22,220 @@ static int fd_kernel = -1;          // Descritor de arquivo para escrever no ker
 static char me_name[MAX_NAME];      // Nome do processo/app
 static int idx = 0;                 // Índice identificador do processo (1..4)
 static pid_t kernel_pid = -1;       // PID do processo kernel para envio de sinais
+static long long work_ns = 1000000000LL; // duração de um PC (--work-ns; padrão 1s)
 
+// Trabalho real por PC (--compute=<spin|mem>,<iterações>, work.h); sem
+// ele, o PC é um sleep de work_ns
+static work_t work = { .mode = WORK_SLEEP };
+static long long work_iters = 0;
 
-// Envia uma syscall de leitura ou escrita ao kernel e se auto-suspende (SIGSTOP)
+// Transporte opcional em memória compartilhada (--ring=<memfd>,<eventfd>);
+// sem ele, usa o pipe + SIGALRM
+static msgring_t *ring = NULL;
+static int bell_fd = -1;
+
+// Portão de estacionamento (--park=<memfd>,<slot>); sem ele, o kernel
+// usa SIGSTOP/SIGCONT
+static _Atomic uint32_t *gate = NULL;
+
+// I/O assíncrono (--aio=<memfd>,<slot>): contador de concluídos publicado
+// pelo kernel; sem ele, toda espera vira MSG_AIO_WAIT
+static kaioslot_t *aio_done = NULL;
+static uint32_t aio_sub = 0;        // pedidos assíncronos submetidos
+
+// Entrega uma mensagem ao kernel pelo transporte ativo.
+// No anel não há SIGALRM: a campainha só toca se o kernel está dormindo.
+static void send_msg(const appmsg_t *m, int nudge){
+    if(ring){
+        msgring_push(ring, bell_fd, m);
+        return;
+    }
+    write(fd_kernel, m, sizeof(*m));
+    if(nudge) kill(kernel_pid, SIGALRM);
+}
+
+
+// Envia uma mensagem que bloqueia o app e se auto-suspende (SIGSTOP)
 // até que o kernel o retome após tratar a requisição.
-static void do_syscall_rw(int rw_flag){
-    appmsg_t m = { .msg_type = MSG_SYSCALL_RW, .pid = getpid(), .arg = rw_flag };
-    write(fd_kernel, &m, sizeof(m));
+static void send_and_stop(const appmsg_t *m){
+    if(gate){
+        // fecha o próprio portão antes de pedir: o CONT do kernel vem depois
+        park_stop(gate);
+        send_msg(m, 0);
+        park_point(gate);
+        return;
+    }
+    send_msg(m, 0);
     // Kernel é quem efetivamente para, mas faremos STOP voluntário para reduzir corrida:
     raise(SIGSTOP);
 }
 
+// Envia uma syscall de leitura ou escrita ao kernel e espera a conclusão
+static void do_syscall_rw(int rw_flag, int dev, int size, long long addr){
+    appmsg_t m = { .msg_type = MSG_SYSCALL_RW, .pid = getpid(), .arg = rw_flag, .dev = dev, .size = size,
+                   .addr = addr };
+    send_and_stop(&m);
+}
+
+// Submete um pedido assíncrono e segue rodando (kaio.h); a campainha
+// acorda o kernel para o pedido entrar logo na fila do dispositivo
+static void aio_submit(int rw_flag, int dev, int size, long long addr){
+    appmsg_t m = { .msg_type = MSG_AIO_SUBMIT, .pid = getpid(), .arg = rw_flag, .dev = dev, .size = size,
+                   .addr = addr };
+    send_msg(&m, 1);
+    aio_sub++;
+}
+
+// Espera até restarem no máximo `inflight` pedidos assíncronos em voo.
+// O poll do contador compartilhado evita a syscall quando já basta.
+// Sem portão, o app não se para depois do pedido: dorme no futex do
+// contador (kaio_wait), e o kernel o para (SIGSTOP) só se o alvo ainda
+// não chegou. Um raise(SIGSTOP) próprio poderia chegar depois do SIGCONT
+// de um alvo já cumprido e deixar o app parado em RUNNING.
+static void aio_wait(int inflight){
+    if(inflight >= (int)aio_sub) return;
+    uint32_t target = aio_sub - (uint32_t)inflight;
+    if(aio_done && kaio_poll(aio_done) >= target) return;
+    appmsg_t m = { .msg_type = MSG_AIO_WAIT, .pid = getpid(), .arg = (int)target };
+    if(gate){
+        park_point(gate); // só pede em execução
+        send_and_stop(&m);
+    } else if(aio_done){
+        send_msg(&m, 1);
+        kaio_wait(aio_done, target);
+    } else {
+        send_and_stop(&m);
+    }
+}
+
+// Consome um PC: dorme até um prazo absoluto a partir de `start`, então um
+// SIGSTOP/SIGCONT no meio não acumula atraso (o prazo não muda)
+static void work_until(const struct timespec *start){
+    struct timespec dl = *start;
+    dl.tv_sec += work_ns / 1000000000LL;
+    dl.tv_nsec += work_ns % 1000000000LL;
+    if(dl.tv_nsec >= 1000000000L){ dl.tv_sec++; dl.tv_nsec -= 1000000000L; }
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &dl, NULL) != 0){}
+    if(gate) park_point(gate); // preemptado no meio do PC: espera o DISPATCH
+}
+
+// Consome um PC com trabalho real: as iterações calibradas pelo kernel,
+// em pedaços; preemptado no meio, para no portão até o DISPATCH
+static void work_compute(void){
+    for(long long left = work_iters; left > 0; left -= WORK_CHUNK){
+        if(!work_run(&work, left < WORK_CHUNK ? left : WORK_CHUNK)){
+            perror("work");
+            exit(1);
+        }
+        if(gate) park_point(gate);
+    }
+}
+
 // Reporta ao kernel o PC atual (estado de execução)
 // e envia SIGALRM para garantir leitura imediata do pipe.
 static void send_status(int pc){
     appmsg_t m = { .msg_type = MSG_APP_STATUS, .pid = getpid(), .arg = pc };
-    write(fd_kernel, &m, sizeof(m));
     // acorda o kernel para drenar pipe (antes usávamos SIGRTMIN+1)
-    kill(kernel_pid, SIGALRM);
+    send_msg(&m, 1);
 }
 
 int main(int argc, char** argv){
     // Converte argumentos e inicializa variáveis básicas
-    if(argc<5){
-        fprintf(stderr,"Uso: %s <fd_kernel_write> <nome> <idx> <kernel_pid>\n", argv[0]);
+    static const struct option lopts[] = {
+        {"ring", required_argument, NULL, 'r'},
+        {"work-ns", required_argument, NULL, 'w'},
+        {"park", required_argument, NULL, 'k'},
+        {"prog", required_argument, NULL, 'P'},
+        {"zygote", required_argument, NULL, 'z'},
+        {"aio", required_argument, NULL, 'a'},
+        {"compute", required_argument, NULL, 'c'},
+        {NULL, 0, NULL, 0},
+    };
+    char mode[8];
+    int opt, ring_fd = -1, park_fd = -1, park_slot = -1, zyg_fd = -1, zyg_slot = -1, aio_fd = -1, aio_slot = -1;
+    const char *prog_text = NULL;
+    while((opt = getopt_long(argc, argv, "", lopts, NULL)) != -1){
+        if(opt == 'r' && sscanf(optarg, "%d,%d", &ring_fd, &bell_fd) == 2) continue;
+        if(opt == 'k' && sscanf(optarg, "%d,%d", &park_fd, &park_slot) == 2) continue;
+        if(opt == 'z' && sscanf(optarg, "%d,%d", &zyg_fd, &zyg_slot) == 2) continue;
+        if(opt == 'a' && sscanf(optarg, "%d,%d", &aio_fd, &aio_slot) == 2) continue;
+        if(opt == 'c' && sscanf(optarg, "%7[a-z],%lld", mode, &work_iters) == 2 && work_iters > 0){
+            for(int m = WORK_SPIN; m <= WORK_MEM; m++)
+                if(strcmp(mode, work_names[m]) == 0) work.mode = m;
+            if(work.mode != WORK_SLEEP) continue;
+        }
+        if(opt == 'P'){ prog_text = optarg; continue; }
+        if(opt == 'w' && (work_ns = atoll(optarg)) > 0) continue;
+        argc = 0; // opção inválida: cai na mensagem de uso
+        break;
+    }
+    if(argc - optind < 4){
+        fprintf(stderr,"Uso: %s [--ring=<memfd>,<eventfd>] [--work-ns=<ns>] [--park=<memfd>,<slot>] [--prog=<passos>] [--zygote=<memfd>,<slot>] [--aio=<memfd>,<slot>] [--compute=<spin|mem>,<iterações>] <fd_kernel_write> <nome> <idx> <kernel_pid>\n", argv[0]);
         return 1;
     }
+    argv += optind - 1;
     fd_kernel = atoi(argv[1]);
     strncpy(me_name, argv[2], sizeof(me_name)-1);
     idx = atoi(argv[3]);
     kernel_pid = (pid_t)atoi(argv[4]);
+    if(ring_fd >= 0 && !(ring = msgring_attach(ring_fd))){
+        perror("msgring_attach");
+        return 1;
+    }
+    if(park_fd >= 0 && !(gate = park_attach(park_fd, park_slot))){
+        perror("park_attach");
+        return 1;
+    }
+    if(aio_fd >= 0 && !(aio_done = kaio_attach(aio_fd, aio_slot))){
+        perror("kaio_attach");
+        return 1;
+    }
+
+    // Zigoto (--spawn pool): espera o kernel atribuir nome, índice e programa
+    if(zyg_fd >= 0){
+        zygslot_t *z = zyg_attach(zyg_fd, zyg_slot);
+        if(!z){
+            perror("zyg_attach");
+            return 1;
+        }
+        close(zyg_fd);
+        zyg_wait(z);
+        memcpy(me_name, z->name, sizeof(me_name));
+        idx = z->idx;
+        if(z->prog[0]) prog_text = strdup(z->prog);
+    }
+
+    // Programa: --prog (carga do kernel, ver workload.h) ou o fixo do índice
+    wl_app_t prog;
+    if(prog_text){
+        memset(&prog, 0, sizeof(prog));
+        if(!wl_parse_prog(prog_text, &prog)) return 1;
+    } else {
+        wl_builtin(idx, &prog);
+    }
 
-    // Define pontos específicos de I/O de acordo com o índice do processo
-    int io_points[5]={0};
-    int io_n=0;
-    if(idx==1){ int tmp[]={3,7,12}; memcpy(io_points,tmp,sizeof(int)*3); io_n=3; }
-    else if(idx==2){ int tmp[]={4,9}; memcpy(io_points,tmp,sizeof(int)*2); io_n=2; }
-    else if(idx==3){ int tmp[]={5,10}; memcpy(io_points,tmp,sizeof(int)*2); io_n=2; }
-    else { int tmp[]={6,11}; memcpy(io_points,tmp,sizeof(int)*2); io_n=2; }
-
-    const int MAX = 15;
-
-    // Loop principal: incrementa o PC, envia STATUS, verifica se há I/O e dorme 1s
-    for(int pc=1; pc<=MAX; ++pc){
-        send_status(pc);            // 1) reporta imediatamente
-        sleep(1);                   // 2) consome 1s de CPU
-
-        // 3) se este PC tem I/O, pede e se bloqueia; quando voltar, segue
-        for(int k=0;k<io_n;k++){
-            if(pc == io_points[k]){
-                do_syscall_rw((pc%2)==0 ? 1 : 0); // 0=READ,1=WRITE
-                break;
-            }
+    // Loop principal: a cada PC envia STATUS e dorme work_ns; a cada passo
+    // de I/O pede e se bloqueia; quando voltar, segue. Pedidos assíncronos
+    // só se bloqueiam no wait (e no fim, esperando todos)
+    wl_cur_t cur;
+    wl_op_t io;
+    int pc = 0, k;
+    wl_start(&cur, idx);
+    while((k = wl_next(&prog, &cur, &io)) != WL_END){
+        if(k != WL_CPU){
+            if(gate) park_point(gate); // só pede I/O em execução
+            if(k == WL_WAIT) aio_wait(io.n);
+            else if(k == WL_AREAD || k == WL_AWRITE) aio_submit(wl_is_write(k), io.dev, io.size, io.addr);
+            else do_syscall_rw(wl_is_write(k), io.dev, io.size, io.addr);
+            continue;
         }
+        struct timespec start;
+        if(gate) park_point(gate);  // 0) só reporta depois do DISPATCH
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        send_status(++pc);          // 1) reporta imediatamente
+        if(work.mode == WORK_SLEEP) work_until(&start); // 2) consome um PC (1s por padrão)
+        else work_compute();        //    ou faz o trabalho real calibrado
     }
+    aio_wait(0);
     return 0;
 }
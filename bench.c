@@ -0,0 +1,754 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+// Benchmarks das estruturas e primitivas usadas pelo KernelSim.
+// Uso: ./bench <cenario> [args]   (sem cenario: lista os disponíveis)
+
+#include "common.h"
+#include "ptable.h"
+#include "msgring.h"
+#include "park.h"
+#include "zygote.h"
+#include "task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+
+/* ====== Helpers ====== */
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// xorshift simples: sequência reprodutível entre execuções
+static unsigned rng_state = 2463534242u;
+static unsigned rnd(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* ====== Cenário ptable ======
+   Compara a tabela antiga (vetor com busca linear + fila circular
+   reconstruída para remover um PID) com ptable.h, em 10..10000 apps.
+   Mede ns por operação: busca por PID, push+pop na fila de prontos
+   e remoção de um PID qualquer da fila (o caso do FINISH). */
+
+typedef struct {
+    pcb_t *v; int n;
+    pid_t *ring; int head, tail, count;
+} old_table_t;
+
+static pcb_t *old_bypid(old_table_t *t, pid_t pid)
+{
+    for (int i = 0; i < t->n; i++)
+        if (t->v[i].pid == pid) return &t->v[i];
+    return NULL;
+}
+static void old_push(old_table_t *t, pid_t p)
+{
+    pcb_t *pp = old_bypid(t, p); // como o rq_push antigo
+    if (pp && pp->st == ST_FINISHED) return;
+    if (t->count >= t->n) return;
+    t->ring[t->tail] = p;
+    t->tail = (t->tail + 1) % t->n;
+    t->count++;
+}
+static int old_pop(old_table_t *t, pid_t *p)
+{
+    if (t->count == 0) return 0;
+    *p = t->ring[t->head];
+    t->head = (t->head + 1) % t->n;
+    t->count--;
+    return 1;
+}
+static void old_remove(old_table_t *t, pid_t pid)
+{
+    int n = t->count;
+    for (int i = 0; i < n; i++) {
+        pid_t p;
+        if (!old_pop(t, &p)) break;
+        if (p != pid) old_push(t, p);
+    }
+}
+
+static int bench_ptable(int argc, char **argv)
+{
+    (void)argc; (void)argv;
+    static const int sizes[] = {10, 100, 1000, 10000};
+    printf("%-6s %-6s %12s %12s %12s\n", "apps", "tabela", "busca(ns)", "push+pop(ns)", "remove(ns)");
+    for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++) {
+        int n = sizes[si];
+        int ops = 2000000 / n < 2000 ? 2000 : 2000000 / n;
+        long long t, sink = 0;
+
+        /* --- tabela antiga --- */
+        old_table_t o = {0};
+        o.n = n;
+        o.v = calloc((size_t)n, sizeof(pcb_t));
+        o.ring = calloc((size_t)n, sizeof(pid_t));
+        for (int i = 0; i < n; i++) { o.v[i].pid = 1000 + 7 * i; old_push(&o, o.v[i].pid); }
+
+        t = now_ns();
+        for (int k = 0; k < ops; k++) sink += old_bypid(&o, 1000 + 7 * (int)(rnd() % (unsigned)n))->last_pc;
+        double o_look = (double)(now_ns() - t) / ops;
+
+        t = now_ns();
+        for (int k = 0; k < ops; k++) { pid_t p = 0; old_pop(&o, &p); old_push(&o, p); }
+        double o_pp = (double)(now_ns() - t) / ops;
+
+        int rops = ops / 10 < 200 ? 200 : ops / 10;
+        t = now_ns();
+        for (int k = 0; k < rops; k++) {
+            pid_t p = 1000 + 7 * (int)(rnd() % (unsigned)n);
+            old_remove(&o, p);
+            old_push(&o, p);
+        }
+        double o_rm = (double)(now_ns() - t) / rops;
+        free(o.v);
+        free(o.ring);
+
+        /* --- ptable.h --- */
+        ptable_t pt;
+        pqueue_t rq;
+        pt_init(&pt, 4); // começa pequena: inclui o custo de crescer
+        pq_init(&rq);
+        for (int i = 0; i < n; i++) pq_push(&pt, &rq, pt_add(&pt, 1000 + 7 * i));
+
+        t = now_ns();
+        for (int k = 0; k < ops; k++) sink += pt_get(&pt, 1000 + 7 * (int)(rnd() % (unsigned)n))->last_pc;
+        double n_look = (double)(now_ns() - t) / ops;
+
+        t = now_ns();
+        for (int k = 0; k < ops; k++) pq_push(&pt, &rq, pq_pop(&pt, &rq));
+        double n_pp = (double)(now_ns() - t) / ops;
+
+        t = now_ns();
+        for (int k = 0; k < rops; k++) {
+            pcb_t *p = pt_get(&pt, 1000 + 7 * (int)(rnd() % (unsigned)n));
+            pq_remove(&pt, p);
+            pq_push(&pt, &rq, p);
+        }
+        double n_rm = (double)(now_ns() - t) / rops;
+        free(pt.v);
+        free(pt.hidx);
+
+        printf("%-6d %-6s %12.1f %12.1f %12.1f\n", n, "antiga", o_look, o_pp, o_rm);
+        printf("%-6d %-6s %12.1f %12.1f %12.1f\n", n, "ptable", n_look, n_pp, n_rm);
+        if (sink == 42) printf(" \n"); // evita que o compilador descarte as buscas
+    }
+    return 0;
+}
+
+/* ====== Cenário ring ======
+   Vários produtores (processos) enviam STATUS ao mesmo tempo para um
+   consumidor que espera como o kernel (epoll). Compara:
+     pipe: write() + kill(SIGALRM) por mensagem, um read() por mensagem
+     shm : anel msgring.h, campainha eventfd só com consumidor dormindo
+   Uso: ./bench ring [produtores=100] [msgs_por_produtor=2000] */
+
+typedef struct {
+    _Atomic int go;          // largada simultânea dos produtores
+    _Atomic long bells;      // quantas vezes a campainha tocou
+} ring_shared_t;
+
+static double ring_run(int shm, int nprod, int per)
+{
+    ring_shared_t *sh = mmap(NULL, sizeof(*sh), PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    memset(sh, 0, sizeof(*sh));
+    int pfd[2] = {-1, -1}, rfd = -1, efd = -1;
+    msgring_t *r = NULL;
+    if (shm) {
+        r = msgring_create((uint32_t)(nprod * 8), &rfd);
+        efd = eventfd(0, EFD_NONBLOCK);
+    } else {
+        if (pipe(pfd) < 0) { perror("pipe"); exit(1); }
+        fcntl(pfd[0], F_SETFL, O_NONBLOCK);
+    }
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGALRM);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    int sfd = signalfd(-1, &mask, SFD_NONBLOCK);
+    int ep = epoll_create1(0);
+    struct epoll_event ev = {.events = EPOLLIN};
+    ev.data.fd = shm ? efd : pfd[0];
+    epoll_ctl(ep, EPOLL_CTL_ADD, ev.data.fd, &ev);
+    ev.data.fd = sfd;
+    epoll_ctl(ep, EPOLL_CTL_ADD, sfd, &ev);
+
+    pid_t me = getpid();
+    for (int i = 0; i < nprod; i++) {
+        if (fork() == 0) {
+            while (!atomic_load(&sh->go)) sched_yield();
+            appmsg_t m = {.msg_type = MSG_APP_STATUS, .pid = getpid()};
+            for (int k = 0; k < per; k++) {
+                m.arg = k;
+                if (shm) {
+                    while (!msgring_try_push(r, &m)) {
+                        if (msgring_ring_bell(r, efd)) atomic_fetch_add(&sh->bells, 1);
+                        sched_yield();
+                    }
+                    if (msgring_ring_bell(r, efd)) atomic_fetch_add(&sh->bells, 1);
+                } else {
+                    (void)write(pfd[1], &m, sizeof(m));
+                    kill(me, SIGALRM);
+                }
+            }
+            _exit(0);
+        }
+    }
+
+    long total = (long)nprod * per, got = 0;
+    long long t = now_ns();
+    atomic_store(&sh->go, 1);
+    while (got < total) {
+        appmsg_t m;
+        if (shm) {
+            while (msgring_pop(r, &m)) got++;
+            if (got == total || !msgring_prepare_sleep(r)) continue;
+        } else {
+            while (read(pfd[0], &m, sizeof(m)) == (ssize_t)sizeof(m)) got++;
+            if (got == total) break;
+        }
+        struct epoll_event evs[2];
+        int n = epoll_wait(ep, evs, 2, -1);
+        if (shm) atomic_store(&r->sleeping, 0);
+        for (int i = 0; i < n; i++) {
+            if (evs[i].data.fd == pfd[0]) continue; // pipe é drenado acima
+            char buf[512];
+            while (read(evs[i].data.fd, buf, sizeof(buf)) > 0) {}
+        }
+    }
+    double secs = (double)(now_ns() - t) / 1e9;
+    while (wait(NULL) > 0) {}
+
+    double syscalls = shm ? (double)atomic_load(&sh->bells) / total : 2.0;
+    printf("%-5s %6d %8d %12.0f %14.3f\n", shm ? "shm" : "pipe", nprod, per,
+           total / secs, syscalls);
+    close(ep);
+    close(sfd);
+    sigprocmask(SIG_UNBLOCK, &mask, NULL);
+    if (shm) { close(rfd); close(efd); munmap(r, msgring_bytes(r->mask + 1)); }
+    else { close(pfd[0]); close(pfd[1]); }
+    munmap(sh, sizeof(*sh));
+    return secs;
+}
+
+static int bench_ring(int argc, char **argv)
+{
+    int nprod = argc > 1 ? atoi(argv[1]) : 100;
+    int per = argc > 2 ? atoi(argv[2]) : 2000;
+    printf("%-5s %6s %8s %12s %14s\n", "modo", "prod", "msgs", "msgs/s", "syscalls/msg");
+    ring_run(0, nprod, per);
+    ring_run(1, nprod, per);
+    return 0;
+}
+
+/* ====== Estatística das amostras ======
+   Todos os cenários de latência guardam uma amostra por operação e
+   imprimem média, p50, p99 e máximo em microssegundos. */
+
+static int cmp_ll(const void *a, const void *b)
+{
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static void lat_header(const char *col)
+{
+    printf("%-20s %8s %10s %10s %10s %10s %12s\n", col, "amostras", "média(us)", "p50(us)",
+           "p99(us)", "máx(us)", "ops/s");
+}
+
+// Ordena `v` e imprime a linha; ops/s é o inverso da média
+static void lat_report(const char *label, long long *v, int n)
+{
+    qsort(v, (size_t)n, sizeof(long long), cmp_ll);
+    double sum = 0;
+    for (int k = 0; k < n; k++) sum += v[k];
+    double mean = sum / n;
+    printf("%-20s %8d %10.2f %10.2f %10.2f %10.2f %12.0f\n", label, n, mean / 1e3,
+           v[n / 2] / 1e3, v[(int)(n * 0.99)] / 1e3, v[n - 1] / 1e3, mean > 0 ? 1e9 / mean : 0);
+}
+
+/* ====== Cenário ipc ======
+   appmsg_t entre dois processos por quatro transportes:
+     pipe      : write()/read() (o --ipc pipe, sem o SIGALRM)
+     socketpair: AF_UNIX SOCK_SEQPACKET, uma mensagem por datagrama
+     shm       : anel msgring.h; campainha eventfd só com leitor dormindo
+     eventfd   : o mesmo anel, mas um write() no eventfd por mensagem
+   Latência: ping-pong (ida e volta) por mensagem. Vazão: um produtor
+   envia `msgs` mensagens seguidas; repete `reps` vezes e reporta cada
+   rodada como uma amostra de tempo por mensagem.
+   Uso: ./bench ipc [msgs=200000] [pingpongs=20000] [reps=5] */
+
+enum { CH_PIPE, CH_SOCK, CH_SHM, CH_EVFD, CH_KINDS };
+static const char *const ch_names[] = {"pipe", "socketpair", "shm", "eventfd"};
+
+// Um sentido de comunicação (leitor e escritor em processos distintos)
+typedef struct {
+    int kind;
+    int rfd, wfd;       // pipe / socketpair
+    msgring_t *r;       // shm / eventfd
+    int efd;
+} chan_t;
+
+static void chan_open(chan_t *c, int kind)
+{
+    memset(c, 0, sizeof(*c));
+    c->kind = kind;
+    int fds[2];
+    if (kind == CH_PIPE && pipe(fds) < 0) { perror("pipe"); exit(1); }
+    if (kind == CH_SOCK && socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) < 0) { perror("socketpair"); exit(1); }
+    if (kind == CH_PIPE || kind == CH_SOCK) {
+        c->rfd = fds[0];
+        c->wfd = fds[1];
+        return;
+    }
+    int mfd = -1;
+    c->r = msgring_create(1024, &mfd);
+    c->efd = eventfd(0, 0);
+    if (!c->r || c->efd < 0) { perror("msgring"); exit(1); }
+    close(mfd); // o mapeamento é herdado no fork
+}
+
+static void chan_close(chan_t *c)
+{
+    if (c->r) {
+        munmap(c->r, msgring_bytes(c->r->mask + 1));
+        close(c->efd);
+    } else {
+        close(c->rfd);
+        close(c->wfd);
+    }
+}
+
+static void chan_send(chan_t *c, const appmsg_t *m)
+{
+    switch (c->kind) {
+    case CH_PIPE:
+    case CH_SOCK:
+        (void)write(c->wfd, m, sizeof(*m));
+        break;
+    case CH_SHM:
+        msgring_push(c->r, c->efd, m);
+        break;
+    case CH_EVFD: {
+        while (!msgring_try_push(c->r, m)) sched_yield();
+        uint64_t one = 1;
+        (void)write(c->efd, &one, sizeof(one));
+        break;
+    }
+    }
+}
+
+static void chan_recv(chan_t *c, appmsg_t *m)
+{
+    uint64_t v;
+    switch (c->kind) {
+    case CH_PIPE:
+    case CH_SOCK:
+        if (read(c->rfd, m, sizeof(*m)) != (ssize_t)sizeof(*m)) { perror("read"); exit(1); }
+        break;
+    case CH_SHM:
+        // como o kernel: drena, marca `sleeping` e só então bloqueia
+        while (!msgring_pop(c->r, m)) {
+            if (!msgring_prepare_sleep(c->r)) continue;
+            (void)read(c->efd, &v, sizeof(v));
+            atomic_store(&c->r->sleeping, 0);
+        }
+        break;
+    case CH_EVFD:
+        while (!msgring_pop(c->r, m)) (void)read(c->efd, &v, sizeof(v));
+        break;
+    }
+}
+
+static void ipc_run(int kind, int msgs, int pings, int reps)
+{
+    chan_t up, down; // app->kernel e kernel->app (só no ping-pong)
+    chan_open(&up, kind);
+    chan_open(&down, kind);
+    pid_t pid = fork();
+    if (pid == 0) {
+        appmsg_t m = {.msg_type = MSG_APP_STATUS, .pid = getpid()};
+        for (int k = 0; k < pings; k++) {
+            chan_recv(&down, &m);
+            chan_send(&up, &m);
+        }
+        for (int r = 0; r < reps; r++) {
+            chan_recv(&down, &m); // largada da rodada
+            for (int k = 0; k < msgs; k++) {
+                m.arg = k;
+                chan_send(&up, &m);
+            }
+        }
+        _exit(0);
+    }
+
+    char label[32];
+    appmsg_t m = {.msg_type = MSG_APP_STATUS};
+    long long *lat = malloc((size_t)pings * sizeof(long long));
+    for (int k = 0; k < pings; k++) {
+        long long t = now_ns();
+        chan_send(&down, &m);
+        chan_recv(&up, &m);
+        lat[k] = now_ns() - t;
+    }
+    snprintf(label, sizeof(label), "%s rtt", ch_names[kind]);
+    lat_report(label, lat, pings);
+
+    long long *per = malloc((size_t)reps * sizeof(long long));
+    for (int r = 0; r < reps; r++) {
+        long long t = now_ns();
+        chan_send(&down, &m);
+        for (int k = 0; k < msgs; k++) chan_recv(&up, &m);
+        per[r] = (now_ns() - t) / msgs;
+    }
+    snprintf(label, sizeof(label), "%s vazão", ch_names[kind]);
+    lat_report(label, per, reps);
+
+    waitpid(pid, NULL, 0);
+    free(lat);
+    free(per);
+    chan_close(&up);
+    chan_close(&down);
+}
+
+static int bench_ipc(int argc, char **argv)
+{
+    int msgs = argc > 1 ? atoi(argv[1]) : 200000;
+    int pings = argc > 2 ? atoi(argv[2]) : 20000;
+    int reps = argc > 3 ? atoi(argv[3]) : 5;
+    if (msgs < 1) msgs = 1;
+    if (pings < 1) pings = 1;
+    if (reps < 1) reps = 1;
+    lat_header("transporte");
+    for (int k = 0; k < CH_KINDS; k++) ipc_run(k, msgs, pings, reps);
+    return 0;
+}
+
+/* ====== Cenário switch ======
+   Latência de troca de contexto kernel->app, como no DISPATCH após um
+   BLOCK: o app está parado, o kernel o retoma e mede até ler o primeiro
+   STATUS do app no pipe; depois o kernel o para de novo.
+     signal: kill(SIGSTOP) / kill(SIGCONT). O app espera em sigsuspend()
+             com SIGCONT bloqueado: um raise(SIGSTOP) próprio, como no
+             do_syscall_rw, correria com o STOP do kernel e poderia
+             engolir um CONT (a corrida que o NUDGE contorna).
+     park  : portão com futex (park.h); o app para sozinho após o STATUS
+   "kernel" é o tempo gasto nas chamadas de stop+cont do lado do kernel.
+   Uso: ./bench switch [rodadas=20000] */
+
+static void sw_nop(int sig) { (void)sig; }
+
+static void switch_run(int use_park, int rounds)
+{
+    parkslot_t *slot = mmap(NULL, sizeof(*slot), PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    _Atomic uint32_t *g = &slot->gate;
+    atomic_store(g, PARK_STOP);
+    int pfd[2];
+    if (pipe(pfd) < 0) { perror("pipe"); exit(1); }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        appmsg_t m = {.msg_type = MSG_APP_STATUS, .pid = getpid()};
+        sigset_t cont, none;
+        sigemptyset(&cont);
+        sigaddset(&cont, SIGCONT);
+        sigprocmask(SIG_BLOCK, &cont, &none);
+        signal(SIGCONT, sw_nop);
+        sigdelset(&none, SIGCONT);
+        if (!use_park) raise(SIGSTOP);
+        for (int k = 1;; k++) {
+            if (use_park) park_point(g);
+            else sigsuspend(&none); // volta depois do CONT (pendente se chegou antes)
+            m.arg = k;
+            (void)write(pfd[1], &m, sizeof(m));
+            if (use_park) park_stop(g); // para sozinho, como no do_syscall_rw
+        }
+    }
+
+    long long *lat = malloc((size_t)rounds * sizeof(long long));
+    long long *kern = malloc((size_t)rounds * sizeof(long long));
+    int st;
+    for (int k = 0; k < rounds; k++) {
+        // espera o app estar de fato parado (dormindo), o caso mais caro
+        if (use_park) while (atomic_load(g) != PARK_WAIT) sched_yield();
+        else waitpid(pid, &st, WUNTRACED);
+
+        long long t0 = now_ns();
+        if (use_park) park_cont(g);
+        else kill(pid, SIGCONT);
+        long long t1 = now_ns();
+        appmsg_t m;
+        if (read(pfd[0], &m, sizeof(m)) != (ssize_t)sizeof(m)) { perror("read"); exit(1); }
+        lat[k] = now_ns() - t0;
+
+        // o kernel também manda parar ao receber a SYSCALL
+        long long t2 = now_ns();
+        if (use_park) park_stop(g);
+        else kill(pid, SIGSTOP);
+        kern[k] = (t1 - t0) + (now_ns() - t2);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, &st, 0);
+
+    lat_report(use_park ? "park cont->STATUS" : "signal cont->STATUS", lat, rounds);
+    lat_report(use_park ? "park kernel" : "signal kernel", kern, rounds);
+    free(lat);
+    free(kern);
+    close(pfd[0]);
+    close(pfd[1]);
+    munmap(slot, sizeof(*slot));
+}
+
+static int bench_switch(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 20000;
+    if (rounds < 1) rounds = 1;
+    lat_header("modo");
+    switch_run(0, rounds);
+    switch_run(1, rounds);
+    return 0;
+}
+
+/* ====== Cenário signals ======
+   Latência de entrega dos sinais que o kernel recebe (IRQ0 = SIGUSR1,
+   IRQ1 = SIGUSR2, "acorda" = SIGALRM): um filho anota o instante e faz
+   kill(); o pai espera como o kernel (signalfd + epoll) e mede até ler o
+   sinal. Um sinal por vez, para não coalescer.
+   Uso: ./bench signals [sinais=20000] */
+
+typedef struct {
+    _Atomic long long sent_ns;
+    _Atomic int seen;        // última rodada lida pelo pai
+} sig_shared_t;
+
+static int bench_signals(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 20000;
+    if (n < 1) n = 1;
+    static const struct { int sig; const char *name; } sigs[] = {
+        {SIGUSR1, "SIGUSR1 (IRQ0)"},
+        {SIGUSR2, "SIGUSR2 (IRQ1)"},
+        {SIGALRM, "SIGALRM"},
+    };
+    lat_header("sinal");
+    for (size_t si = 0; si < sizeof(sigs) / sizeof(sigs[0]); si++) {
+        sig_shared_t *sh = mmap(NULL, sizeof(*sh), PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        memset(sh, 0, sizeof(*sh));
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, sigs[si].sig);
+        sigprocmask(SIG_BLOCK, &mask, NULL);
+        int sfd = signalfd(-1, &mask, SFD_NONBLOCK);
+        int ep = epoll_create1(0);
+        struct epoll_event ev = {.events = EPOLLIN, .data.fd = sfd};
+        epoll_ctl(ep, EPOLL_CTL_ADD, sfd, &ev);
+
+        pid_t me = getpid();
+        pid_t pid = fork();
+        if (pid == 0) {
+            for (int k = 1; k <= n; k++) {
+                while (atomic_load(&sh->seen) != k - 1) sched_yield();
+                atomic_store(&sh->sent_ns, now_ns());
+                kill(me, sigs[si].sig);
+            }
+            _exit(0);
+        }
+
+        long long *lat = malloc((size_t)n * sizeof(long long));
+        for (int k = 0; k < n; k++) {
+            struct signalfd_siginfo si_buf;
+            while (read(sfd, &si_buf, sizeof(si_buf)) != (ssize_t)sizeof(si_buf))
+                epoll_wait(ep, &ev, 1, -1);
+            lat[k] = now_ns() - atomic_load(&sh->sent_ns);
+            atomic_store(&sh->seen, k + 1);
+        }
+        waitpid(pid, NULL, 0);
+        lat_report(sigs[si].name, lat, n);
+        free(lat);
+        close(ep);
+        close(sfd);
+        sigprocmask(SIG_UNBLOCK, &mask, NULL);
+        munmap(sh, sizeof(*sh));
+    }
+    return 0;
+}
+
+/* ====== Cenário spawn ======
+   Custo de criar um app pelos três caminhos do kernel (--spawn): fork() +
+   exec, posix_spawn() e zigoto já executado (zygote.h), até o primeiro
+   STATUS chegar no pipe. Mede também o lado do pai (o que o loop do
+   kernel gasta). Precisa do ./app compilado no diretório atual.
+   Uso: ./bench spawn [apps=500] */
+
+static int bench_spawn(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 500;
+    if (n < 1) n = 1;
+    if (access("./app", X_OK) != 0) { perror("./app"); return 1; }
+    int pfd[2];
+    if (pipe(pfd) < 0) { perror("pipe"); return 1; }
+    fcntl(pfd[0], F_SETFD, FD_CLOEXEC);
+    long long *tcall = malloc((size_t)n * sizeof(long long));
+    long long *tfirst = malloc((size_t)n * sizeof(long long));
+    pid_t *pids = malloc((size_t)n * sizeof(pid_t));
+    int zfd;
+    zygslot_t *zyg = zyg_create(n, &zfd);
+    if (!tcall || !tfirst || !pids || !zyg) { perror("spawn"); return 1; }
+    char fdw[32], kpid[32], zarg[48];
+    snprintf(fdw, sizeof(fdw), "%d", pfd[1]);
+    snprintf(kpid, sizeof(kpid), "%d", getpid());
+    signal(SIGALRM, SIG_IGN); // o app avisa o "kernel" a cada STATUS
+    char *av[] = {"./app", "--work-ns=1000000000", fdw, "A1", "1", kpid, NULL};
+    char *zav[] = {"./app", "--work-ns=1000000000", zarg, fdw, "Z", "0", kpid, NULL};
+
+    lat_header("caminho");
+    for (int mode = 0; mode < 3; mode++) {
+        // zigotos: todos criados e dormindo antes de medir
+        for (int k = 0; mode == 2 && k < n; k++) {
+            snprintf(zarg, sizeof(zarg), "--zygote=%d,%d", zfd, k);
+            if (posix_spawn(&pids[k], "./app", NULL, NULL, zav, environ) != 0) { perror("posix_spawn"); return 1; }
+        }
+        for (int k = 0; mode == 2 && k < n; k++)
+            while (atomic_load(&zyg[k].state) != ZYG_WAIT) usleep(100);
+
+        for (int k = 0; k < n; k++) {
+            long long t0 = now_ns();
+            pid_t pid = -1;
+            if (mode == 0) {
+                pid = fork();
+                if (pid == 0) {
+                    execv("./app", av);
+                    _exit(127);
+                }
+            } else if (mode == 1) {
+                if (posix_spawn(&pid, "./app", NULL, NULL, av, environ) != 0) { perror("posix_spawn"); return 1; }
+            } else {
+                pid = pids[k];
+                zyg_assign(&zyg[k], 1, "A1", "");
+            }
+            tcall[k] = now_ns() - t0;
+            appmsg_t m;
+            if (read(pfd[0], &m, sizeof(m)) != (ssize_t)sizeof(m)) { perror("read"); return 1; }
+            tfirst[k] = now_ns() - t0;
+            kill(pid, SIGKILL);
+            waitpid(pid, NULL, 0);
+        }
+        static const char *const label[3][2] = {
+            {"fork", "fork+exec+STATUS"},
+            {"posix_spawn", "posix_spawn+STATUS"},
+            {"zigoto: atribuir", "zigoto+STATUS"},
+        };
+        lat_report(label[mode][0], tcall, n);
+        lat_report(label[mode][1], tfirst, n);
+    }
+    free(tcall);
+    free(tfirst);
+    free(pids);
+    close(pfd[0]);
+    close(pfd[1]);
+    return 0;
+}
+
+/* ====== Cenário coro ======
+   Troca entre apps no --coro: o kernel retoma em rodízio N corrotinas
+   (task.h), cada uma devolvendo o controle logo em seguida, como um app
+   que só envia STATUS. Cada rodada (todas as N uma vez) vira uma amostra
+   de tempo por retomada (ida e volta), com 1, 1000 e N tarefas: com
+   muitas, os contextos e pilhas deixam de caber no cache.
+   Uso: ./bench coro [tarefas=100000] [rodadas=20] */
+
+static task_t *coro_tasks;
+static int coro_cur;
+
+static void coro_body(void)
+{
+    task_t *t = &coro_tasks[coro_cur];
+    for (;;) task_yield(t);
+}
+
+static int bench_coro(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    if (n < 1) n = 1;
+    if (rounds < 1) rounds = 1;
+    coro_tasks = calloc((size_t)n, sizeof(task_t));
+    char *stacks = task_arena((size_t)n);
+    long long *per = malloc((size_t)rounds * sizeof(long long));
+    if (!coro_tasks || !stacks || !per) { perror("coro"); return 1; }
+    for (int k = 0; k < n; k++) {
+        task_init(&coro_tasks[k], stacks + (size_t)k * TASK_STACK, coro_body);
+        coro_cur = k;
+        task_resume(&coro_tasks[k]); // primeira entrada: toca a pilha
+    }
+    lat_header("tarefas");
+    int sizes[3] = {1, 1000 < n ? 1000 : n, n};
+    for (int s = 0; s < 3; s++) {
+        if (s > 0 && sizes[s] == sizes[s - 1]) continue;
+        for (int r = 0; r < rounds; r++) {
+            long long t0 = now_ns();
+            int reps = sizes[s] < 1000 ? 1000 : 1;  // rodada curta: repete
+            for (int x = 0; x < reps; x++)
+                for (int k = 0; k < sizes[s]; k++) task_resume(&coro_tasks[k]);
+            per[r] = (now_ns() - t0) / ((long long)reps * sizes[s]);
+        }
+        char label[32];
+        snprintf(label, sizeof(label), "%d", sizes[s]);
+        lat_report(label, per, rounds);
+    }
+    free(per);
+    free(coro_tasks);
+    munmap(stacks, (size_t)n * TASK_STACK);
+    return 0;
+}
+
+/* ====== Main ====== */
+static const struct {
+    const char *name;
+    int (*fn)(int, char **);
+    const char *help;
+} scenarios[] = {
+    {"ptable", bench_ptable, "tabela de processos e filas: 10..10000 apps"},
+    {"ring",   bench_ring,   "app->kernel: pipe+SIGALRM vs anel em memória compartilhada"},
+    {"ipc",    bench_ipc,    "appmsg_t: pipe, socketpair, anel shm e eventfd (rtt e vazão)"},
+    {"switch", bench_switch, "SIGSTOP/SIGCONT vs portões com futex até o 1o STATUS"},
+    {"signals", bench_signals, "latência de entrega de SIGUSR1/SIGUSR2/SIGALRM (signalfd)"},
+    {"coro",   bench_coro,   "retomada de corrotinas do --coro com 1, 1000 e N tarefas"},
+    {"spawn",  bench_spawn,  "fork+exec, posix_spawn e zigoto até o primeiro STATUS"},
+};
+
+int main(int argc, char **argv)
+{
+    size_t ns = sizeof(scenarios) / sizeof(scenarios[0]);
+    if (argc >= 2)
+        for (size_t i = 0; i < ns; i++)
+            if (strcmp(argv[1], scenarios[i].name) == 0)
+                return scenarios[i].fn(argc - 1, argv + 1);
+
+    fprintf(stderr, "Uso: %s <cenario> [args]\n", argv[0]);
+    for (size_t i = 0; i < ns; i++)
+        fprintf(stderr, "  %-10s %s\n", scenarios[i].name, scenarios[i].help);
+    return 1;
+}
@@ -0,0 +1,224 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef CHROME_H
+#define CHROME_H
+
+/* Exportação da linha do tempo no formato Chrome Trace Event (JSON),
+   aberto em chrome://tracing ou ui.perfetto.dev.
+
+   Consome os mesmos registros de trace.h, ao vivo (kernel_sim --chrome)
+   ou a partir de um arquivo (ktrace --chrome), e gera três grupos:
+     CPUs        uma linha por núcleo: fatia com o app em execução, IRQ0
+     Apps        uma linha por app: fatias READY / RUNNING / BLOCKED,
+                 instantes de PREEMPT, NUDGE e STEAL
+     Dispositivos uma linha por Dn: fatia IO-START..IO-DONE, IRQ1
+   e contadores com o tamanho da fila de prontos e de I/O, onde um
+   acúmulo em D1 (efeito comboio) aparece como uma rampa. */
+
+#include "common.h"
+#include "ptable.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { CH_CPUS = 1, CH_APPS = 2, CH_DEVS = 3 };
+
+typedef struct {
+    pid_t     pid;      // -1 = livre
+    long long since;
+} ch_slot_t;
+
+typedef struct {
+    FILE      *f;
+    int        first;       // controla as vírgulas entre eventos
+    ptable_t   apps;        // estado de cada app: st, t_state, cpu, name
+    ch_slot_t *cpu, *dev;   // fatia aberta por núcleo / dispositivo
+    int        ncpu, ndev;
+    uint32_t   last_rq, last_ioq;
+    long long  last_t;
+} chrome_t;
+
+// Separador antes de cada evento do vetor traceEvents
+static inline void ch_sep(chrome_t *c)
+{
+    fputs(c->first ? "\n" : ",\n", c->f);
+    c->first = 0;
+}
+
+static inline void ch_meta(chrome_t *c, int pid, int tid, const char *kind, const char *name)
+{
+    ch_sep(c);
+    fprintf(c->f, "{\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"name\":\"%s\",\"args\":{\"name\":\"%s\"}}",
+            pid, tid, kind, name);
+}
+
+static inline void ch_slice(chrome_t *c, int pid, int tid, const char *name, long long t0, long long t1)
+{
+    ch_sep(c);
+    fprintf(c->f, "{\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f}",
+            pid, tid, name, t0 / 1e3, (t1 - t0) / 1e3);
+}
+
+static inline void ch_instant(chrome_t *c, int pid, int tid, const char *name, long long t)
+{
+    ch_sep(c);
+    fprintf(c->f, "{\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%d,\"name\":\"%s\",\"ts\":%.3f}",
+            pid, tid, name, t / 1e3);
+}
+
+// Garante a linha `i` (núcleo ou dispositivo) e lhe dá nome
+static inline ch_slot_t *ch_row(chrome_t *c, ch_slot_t **v, int *n, int i, int group, const char *prefix)
+{
+    if (i < 0) return NULL;
+    while (*n <= i) {
+        *v = realloc(*v, (size_t)(*n + 1) * sizeof(ch_slot_t));
+        if (!*v) { perror("chrome"); exit(1); }
+        (*v)[*n].pid = -1;
+        char nm[32];
+        snprintf(nm, sizeof(nm), "%s%d", prefix, *n + 1);
+        ch_meta(c, group, *n + 1, "thread_name", nm);
+        (*n)++;
+    }
+    return &(*v)[i];
+}
+
+static inline int chrome_open(chrome_t *c, const char *path)
+{
+    memset(c, 0, sizeof(*c));
+    c->f = fopen(path, "w");
+    if (!c->f) return 0;
+    c->first = 1;
+    pt_init(&c->apps, 64);
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", c->f);
+    ch_meta(c, CH_CPUS, 0, "process_name", "CPUs");
+    ch_meta(c, CH_APPS, 0, "process_name", "Apps");
+    ch_meta(c, CH_DEVS, 0, "process_name", "Dispositivos");
+    return 1;
+}
+
+static const char *const ch_state_name[] = {"READY", "RUNNING", "BLOCKED", "FINISHED"};
+
+// Fecha a fatia de estado do app e abre a do novo estado
+static inline void ch_app_state(chrome_t *c, pcb_t *p, pstate_t st, long long t)
+{
+    if (p->st != ST_FINISHED && t > p->t_state)
+        ch_slice(c, CH_APPS, p->pid, ch_state_name[p->st], p->t_state, t);
+    p->st = st;
+    p->t_state = t;
+}
+
+// Fecha a fatia do núcleo (app que estava rodando nele)
+static inline void ch_cpu_off(chrome_t *c, int cpu, long long t)
+{
+    ch_slot_t *s = ch_row(c, &c->cpu, &c->ncpu, cpu, CH_CPUS, "CPU");
+    if (!s || s->pid < 0) return;
+    pcb_t *p = pt_get(&c->apps, s->pid);
+    ch_slice(c, CH_CPUS, cpu + 1, p ? p->name : "?", s->since, t);
+    s->pid = -1;
+}
+
+static inline void chrome_event(chrome_t *c, const trace_rec_t *r, const char *name)
+{
+    long long t = r->t_ns;
+    pcb_t *p = r->pid > 0 ? pt_get(&c->apps, r->pid) : NULL;
+    c->last_t = t;
+
+    switch (r->type) {
+    case TR_SPAWN:
+        if (!p) p = pt_add(&c->apps, r->pid);
+        snprintf(p->name, sizeof(p->name), "%s", name);
+        p->st = ST_READY;
+        p->t_state = t;
+        p->cpu = -1;
+        ch_meta(c, CH_APPS, r->pid, "thread_name", p->name);
+        break;
+    case TR_DISPATCH:
+        if (!p) break;
+        ch_app_state(c, p, ST_RUNNING, t);
+        p->cpu = r->cpu;
+        ch_cpu_off(c, r->cpu, t);
+        c->cpu[r->cpu].pid = r->pid;
+        c->cpu[r->cpu].since = t;
+        break;
+    case TR_PREEMPT:
+    case TR_NUDGE:
+        if (!p) break;
+        ch_cpu_off(c, p->cpu, t);
+        ch_app_state(c, p, ST_READY, t);
+        ch_instant(c, CH_APPS, r->pid, r->type == TR_NUDGE ? "NUDGE" : "PREEMPT", t);
+        break;
+    case TR_STEAL:
+        if (p) ch_instant(c, CH_APPS, r->pid, "STEAL", t);
+        break;
+    case TR_BLOCK:
+        if (!p) break;
+        ch_cpu_off(c, p->cpu, t);
+        ch_app_state(c, p, ST_BLOCKED, t);
+        break;
+    case TR_SYSCALL:
+        if (p && p->st == ST_READY) ch_app_state(c, p, ST_BLOCKED, t);
+        break;
+    case TR_IO_DONE:
+    case TR_AIO_WAKE:
+        if (p) ch_app_state(c, p, ST_READY, t);
+        break;
+    case TR_AIO_SUBMIT:
+        if (p) ch_instant(c, CH_APPS, r->pid, "AIO", t);
+        break;
+    case TR_FINISHED:
+        if (!p) break;
+        if (p->st == ST_RUNNING) ch_cpu_off(c, p->cpu, t);
+        ch_app_state(c, p, ST_FINISHED, t);
+        break;
+    case TR_IO_START: {
+        ch_slot_t *s = ch_row(c, &c->dev, &c->ndev, r->a, CH_DEVS, "D");
+        s->pid = r->pid;
+        s->since = t;
+        break;
+    }
+    case TR_IRQ1:
+    case TR_IRQ1_STALE: {
+        ch_slot_t *s = ch_row(c, &c->dev, &c->ndev, r->a, CH_DEVS, "D");
+        if (s && s->pid >= 0) {
+            pcb_t *q = pt_get(&c->apps, s->pid);
+            ch_slice(c, CH_DEVS, r->a + 1, q ? q->name : "?", s->since, t);
+            s->pid = -1;
+        }
+        ch_instant(c, CH_DEVS, r->a + 1, "IRQ1", t);
+        break;
+    }
+    case TR_IRQ0:
+    case TR_IRQ0_KEEP:
+    case TR_IRQ0_ONLY:
+        ch_row(c, &c->cpu, &c->ncpu, r->cpu, CH_CPUS, "CPU");
+        ch_instant(c, CH_CPUS, r->cpu + 1, "IRQ0", t);
+        break;
+    }
+
+    // contadores: só quando mudam
+    if (r->rq != c->last_rq || r->ioq != c->last_ioq) {
+        ch_sep(c);
+        fprintf(c->f, "{\"ph\":\"C\",\"pid\":%d,\"name\":\"filas\",\"ts\":%.3f,"
+                      "\"args\":{\"prontos\":%u,\"io\":%u}}",
+                CH_CPUS, t / 1e3, r->rq, r->ioq);
+        c->last_rq = r->rq;
+        c->last_ioq = r->ioq;
+    }
+}
+
+// Fecha as fatias ainda abertas e o JSON
+static inline void chrome_close(chrome_t *c)
+{
+    for (int i = 0; i < c->ncpu; i++) ch_cpu_off(c, i, c->last_t);
+    for (int i = 0; i < c->apps.n; i++) ch_app_state(c, &c->apps.v[i], ST_FINISHED, c->last_t);
+    fputs("\n]}\n", c->f);
+    fclose(c->f);
+    free(c->apps.v);
+    free(c->apps.hidx);
+    free(c->cpu);
+    free(c->dev);
+}
+
+#endif
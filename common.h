@@ -4,32 +4,47 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+/* memfd_create, signalfd, etc.: common.h é sempre o primeiro include */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdint.h>
 #include <sys/types.h>
 
-/* Limites */
-#define MAX_APPS 6
+/* Limites (a tabela de processos é dinâmica; ver ptable.h) */
 #define MAX_NAME 16
 
 /* Sinais usados:
    - SIGUSR1 -> IRQ0 (time-slice a cada 1s)
-   - SIGUSR2 -> IRQ1 (fim de I/O 3s após cada pedido)
+   - SIGUSR2 -> IRQ1 (fim de I/O após o tempo de serviço do dispositivo)
    - SIGALRM -> “acorda kernel” para drenar pipe app->kernel
 */
 
 /* Tipos de mensagens app->kernel */
-enum { MSG_SYSCALL_RW = 1, MSG_APP_STATUS = 2, MSG_IO_START = 3 };
+enum { MSG_SYSCALL_RW = 1, MSG_APP_STATUS = 2, MSG_IO_START = 3, MSG_TICK = 4,
+       MSG_AIO_SUBMIT = 5, MSG_AIO_WAIT = 6 };
 
 /* app -> kernel */
 typedef struct {
-    int   msg_type;   // MSG_SYSCALL_RW ou MSG_APP_STATUS
+    int   msg_type;   // MSG_SYSCALL_RW, MSG_APP_STATUS ou MSG_AIO_* (kaio.h)
     pid_t pid;        // PID do app remetente
-    int   arg;        // SYSCALL: 0=READ,1=WRITE | STATUS: PC atual
+    int   arg;        // SYSCALL/AIO_SUBMIT: 0=READ,1=WRITE | STATUS: PC atual
+                      // AIO_WAIT: alvo de pedidos assíncronos concluídos
+    int   dev;        // SYSCALL: dispositivo (0..n-1) ou -1 = kernel escolhe
+    int   size;       // SYSCALL: bytes do pedido (0 = um pedido padrão)
+    long long addr;   // SYSCALL: endereço em bytes no dispositivo
 } appmsg_t;
 
 /* kernel -> inter_controller */
 typedef struct {
-    int msg_type; // sempre MSG_IO_START
+    int   msg_type;   // MSG_IO_START ou MSG_TICK (--tickless)
+    int   dev;        // dispositivo que iniciou serviço
+    pid_t pid;        // processo atendido
+    long long service_ns; // duração do serviço | TICK: período do IRQ0
+    uint32_t  req_id;     // identificador do pedido (volta na conclusão)
+    long long t_start_ns; // instante do IO-START no kernel | TICK: próximo
+                          // IRQ0 (CLOCK_MONOTONIC), 0 = para o timer
 } icmsg_t;
 
 typedef enum { ST_READY=0, ST_RUNNING=1, ST_BLOCKED=2, ST_FINISHED=3 } pstate_t;
@@ -41,6 +56,52 @@ typedef struct {
     pstate_t st;
     int   last_pc;       // último PC informado pelo app (contexto salvo)
     int   last_syscall;  // 0=READ, 1=WRITE, -1=nenhum (parâmetro da última syscall)
+    int   io_dev;        // dispositivo da SYSCALL de I/O pendente, -1 = nenhum
+    int   aio_inflight;  // pedidos assíncronos submetidos e não concluídos (kaio.h)
+    int   aio_done;      // pedidos assíncronos concluídos
+    int   aio_target;    // MSG_AIO_WAIT: bloqueado até aio_done chegar aqui
+
+    /* escalonamento (interface de políticas em kernel_sim.c) */
+    int   weight;        // --weights: prioridade / bilhetes / peso CFS
+    int   on_rq;         // está na fila de prontos
+    int   level;         // MLFQ: nível atual
+    int   slice_ticks;   // MLFQ: ticks usados do quantum do nível
+    long long vtime;     // stride: passe | CFS: vruntime
+    long long run_start_ns; // início do trecho de CPU ainda não cobrado
+    long long skey;      // chave no heap de prontos
+    unsigned long long seq; // desempate FIFO no heap
+    int   heap_pos;      // posição no heap (-1 = fora)
+    long long burst_est;   // rajada de CPU estimada (média exponencial; 0 = sem histórico)
+    long long burst_cpu0;  // cpu_ns no início da rajada atual
+    int   slice_target;  // --adaptive: ticks da fatia deste dispatch
+    int   slice_used;    // ticks já usados desde o dispatch
+
+    /* multi-núcleo */
+    int   cpu;           // núcleo onde roda / espera (-1 = nenhum ainda)
+    int   affinity;      // núcleo fixo (--affinity), -1 = qualquer
+    int   host_cpu;      // CPU real à qual o app está fixado (-1 = nenhuma)
+
+    /* métricas (instantes em ns no relógio do kernel) */
+    long long t_arrival;    // entrada na fila de prontos pela 1a vez
+    long long t_first_run;  // primeiro DISPATCH (-1 = ainda não rodou)
+    long long t_finish;     // FINISHED
+    long long t_state;      // última troca de estado
+    long long cpu_ns, wait_ns, blocked_ns; // tempo em RUNNING / READY / BLOCKED
+    int   ndispatch, npreempt, nio;
+
+    int   app;           // índice do app (A<app+1>): programa, app do --des
+    int   slot;          // vaga do processo: portão (park.h) e zigoto (zygote.h)
+    int   pidfd;         // pidfd do processo (-1 sem): término e sinais
+
+    /* CPU medida no host (modo real; ver cpu_measure em kernel_sim.c) */
+    clockid_t clk;       // relógio de CPU do processo
+    int   clk_ok;        // clk vale (0 no --des e depois de colhido)
+    long long host_cpu_ns; // CPU usada até a última leitura (no fim, o rusage)
+
+    /* índice na tabela e links da fila em que está (ptable.h) */
+    int   idx;
+    struct pqueue *q;    // fila atual (NULL = fora de fila)
+    int   q_next, q_prev;
 } pcb_t;
 
 #endif
@@ -0,0 +1,92 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef CQRING_H
+#define CQRING_H
+
+/* Fila de conclusões IC->kernel (estilo io_uring): anel SPSC em memória
+   compartilhada. O IC é o único produtor, o kernel o único consumidor.
+   Cada entrada identifica o pedido (req_id, pid, dispositivo) e carrega
+   os instantes de início e fim do serviço.
+
+   IRQ1 (SIGUSR2) vira só campainha: pode coalescer à vontade, porque o
+   kernel drena todas as entradas publicadas de uma vez — nenhuma
+   conclusão se perde. Header-only, usado por kernel_sim.c e
+   inter_controller.c. */
+
+#include "common.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+typedef struct {
+    uint32_t  req_id;      // identificador atribuído pelo kernel no IO-START
+    pid_t     pid;
+    int       dev;
+    long long t_start_ns;  // kernel iniciou o serviço (CLOCK_MONOTONIC)
+    long long t_done_ns;   // IC concluiu o serviço
+} cqe_t;
+
+typedef struct {
+    _Atomic uint32_t head;   // próxima entrada a consumir (kernel)
+    char _pad0[60];
+    _Atomic uint32_t tail;   // próxima entrada a publicar (IC)
+    char _pad1[60];
+    uint32_t mask;           // capacidade-1 (potência de 2)
+    cqe_t cqes[];
+} cqring_t;
+
+static inline size_t cq_bytes(uint32_t cap)
+{
+    return sizeof(cqring_t) + (size_t)cap * sizeof(cqe_t);
+}
+
+// Cria o anel num memfd (kernel); fd herdado pelo IC no exec
+static inline cqring_t *cq_create(uint32_t cap, int *fd_out)
+{
+    uint32_t c = 64;
+    while (c < cap) c <<= 1;
+    int fd = memfd_create("ksim-cq", 0);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, (off_t)cq_bytes(c)) < 0) { close(fd); return NULL; }
+    cqring_t *q = mmap(NULL, cq_bytes(c), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (q == MAP_FAILED) { close(fd); return NULL; }
+    q->mask = c - 1;
+    *fd_out = fd;
+    return q;
+}
+
+static inline cqring_t *cq_attach(int fd)
+{
+    cqring_t *hdr = mmap(NULL, sizeof(cqring_t), PROT_READ, MAP_SHARED, fd, 0);
+    if (hdr == MAP_FAILED) return NULL;
+    uint32_t cap = hdr->mask + 1;
+    munmap(hdr, sizeof(cqring_t));
+    cqring_t *q = mmap(NULL, cq_bytes(cap), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return q == MAP_FAILED ? NULL : q;
+}
+
+// Publica uma conclusão (só o IC); 0 se o anel está cheio
+static inline int cq_push(cqring_t *q, const cqe_t *e)
+{
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (tail - head > q->mask) return 0;
+    q->cqes[tail & q->mask] = *e;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+// Consome até `max` conclusões de uma vez (só o kernel)
+static inline int cq_pop_batch(cqring_t *q, cqe_t *out, int max)
+{
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    int n = 0;
+    while (head != tail && n < max) out[n++] = q->cqes[head++ & q->mask];
+    atomic_store_explicit(&q->head, head, memory_order_release);
+    return n;
+}
+
+#endif
@@ -2,14 +2,70 @@
 // Giovana Nogueira 2220372    
    
 #include "common.h"
+#include "cqring.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
 
 // PID do processo-filho responsável pelo timer (gera IRQ0)
 static pid_t tmr_pid = -1;
 
+// I/Os em andamento (um por dispositivo ocupado), num heap de mínimo
+// ordenado pelo instante de término: o IC dorme até o próximo prazo em vez
+// de bloquear em sleep() por pedido, então dispositivos se sobrepõem.
+typedef struct {
+    long long due_ns;   // término (CLOCK_MONOTONIC)
+    int   dev;
+    pid_t pid;
+    uint32_t  req_id;
+    long long t_start_ns;
+} pending_t;
+static pending_t *heap = NULL;
+static int heap_n = 0, heap_cap = 0;
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void heap_push(pending_t e)
+{
+    if (heap_n == heap_cap) {
+        heap_cap = heap_cap ? 2 * heap_cap : 16;
+        heap = realloc(heap, (size_t)heap_cap * sizeof(pending_t));
+        if (!heap) { perror("heap"); _exit(1); }
+    }
+    int i = heap_n++;
+    while (i > 0 && heap[(i - 1) / 2].due_ns > e.due_ns) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = e;
+}
+
+static pending_t heap_pop(void)
+{
+    pending_t top = heap[0], last = heap[--heap_n];
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= heap_n) break;
+        if (c + 1 < heap_n && heap[c + 1].due_ns < heap[c].due_ns) c++;
+        if (last.due_ns <= heap[c].due_ns) break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    if (heap_n > 0) heap[i] = last;
+    return top;
+}
+
 // Handler de término: encerra o timer filho e finaliza o IC.
 static void on_term(int s){
     (void)s;
@@ -19,38 +75,99 @@ static void on_term(int s){
 
 // argv[1] = fd_read (kernel->IC)
 // argv[2] = kernel_pid
+// argv[3] = fd da fila de conclusões (memfd, ver cqring.h)
+// argv[4] = período do IRQ0 em ns (opcional; padrão 1s; 0 = timer parado
+//           até o kernel programá-lo com MSG_TICK, no --tickless)
 int main(int argc, char** argv){
-    // Recebe descritor de leitura (pipe kernel->IC) e PID do kernel
-    if(argc<3){
-        fprintf(stderr, "Uso: %s <fd_read> <kernel_pid>\n", argv[0]);
+    // Recebe descritor de leitura (pipe kernel->IC), PID do kernel e fila de conclusões
+    if(argc<4){
+        fprintf(stderr, "Uso: %s <fd_read> <kernel_pid> <cq_fd> [quantum_ns]\n", argv[0]);
         return 1;
     }
     int fd_r = atoi(argv[1]);
     pid_t kpid = (pid_t)atoi(argv[2]);
+    cqring_t *cq = cq_attach(atoi(argv[3]));
+    if(!cq){ perror("cq_attach"); return 1; }
+    long long quantum_ns = argc > 4 ? atoll(argv[4]) : 1000000000LL;
+    if(quantum_ns != 0 && quantum_ns < 1000) quantum_ns = 1000;
 
     signal(SIGTERM, on_term);
 
-    // Cria processo-filho que gera interrupções de tempo (IRQ0) a cada 1s
+    // Cria processo-filho que gera interrupções de tempo (IRQ0) a cada quantum.
+    // timerfd periódico: os disparos ficam em múltiplos exatos do período a
+    // partir do início, sem acumular o atraso de cada volta (o sleep(1)
+    // antigo derivava a cada tick). O timerfd é criado antes do fork: o IC
+    // reprograma o mesmo timer (MSG_TICK) e o filho só lê os disparos;
+    // parado, o filho dorme no read sem gerar IRQ0.
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if(tfd < 0){ perror("timerfd"); return 1; }
+    if(quantum_ns > 0){
+        struct itimerspec its;
+        its.it_interval.tv_sec = quantum_ns / 1000000000LL;
+        its.it_interval.tv_nsec = quantum_ns % 1000000000LL;
+        its.it_value = its.it_interval;
+        timerfd_settime(tfd, 0, &its, NULL);
+    }
     tmr_pid = fork();
     if(tmr_pid==0){
-        // Timer de IRQ0 (1s)
         for(;;){
-            sleep(1);
+            uint64_t ticks; // >1 se atrasamos; o kernel trata um IRQ0 por vez
+            if(read(tfd, &ticks, sizeof(ticks)) != sizeof(ticks)) continue;
             kill(kpid, SIGUSR1); // IRQ0
         }
     }
 
-    // Loop principal: aguarda mensagens do kernel no pipe.
-    // Ao receber MSG_IO_START, espera 3s e envia IRQ1 (simula fim de I/O).
-    // Caso contrário, dorme brevemente para evitar busy-wait.
+    // Loop principal: aguarda mensagens do kernel no pipe ou o próximo
+    // prazo do heap. Cada MSG_IO_START agenda o término do serviço daquele
+    // dispositivo; cada prazo vencido vira uma entrada na fila de conclusões,
+    // e um IRQ1 por rodada avisa o kernel (ele drena tudo de uma vez).
     for(;;){
+        long long now = now_ns();
+        int posted = 0;
+        while(heap_n > 0 && heap[0].due_ns <= now){
+            pending_t p = heap_pop();
+            cqe_t e = { .req_id = p.req_id, .pid = p.pid, .dev = p.dev,
+                        .t_start_ns = p.t_start_ns, .t_done_ns = now };
+            if(!cq_push(cq, &e)){
+                // fila cheia: tenta de novo em 1ms, depois que o kernel drenar
+                p.due_ns = now + 1000000LL;
+                heap_push(p);
+                break;
+            }
+            posted++;
+        }
+        if(posted || (heap_n > 0 && heap[0].due_ns <= now)) kill(kpid, SIGUSR2); // IRQ1
+
+        // espera com resolução de ns (ppoll): prazos de I/O abaixo de 1ms
+        struct timespec ts, *timeout = NULL;
+        if(heap_n > 0){
+            long long left = heap[0].due_ns - now;
+            ts.tv_sec = left / 1000000000LL;
+            ts.tv_nsec = left % 1000000000LL;
+            timeout = &ts;
+        }
+
+        struct pollfd pfd = { .fd = fd_r, .events = POLLIN };
+        if(ppoll(&pfd, 1, timeout, NULL) <= 0) continue;
+
         icmsg_t m;
         ssize_t r = read(fd_r, &m, sizeof(m));
+        if(r == 0) on_term(0); // kernel fechou o pipe
         if(r == sizeof(m) && m.msg_type == MSG_IO_START){
-            sleep(3);
-            kill(kpid, SIGUSR2); // IRQ1
-        }else{
-            usleep(10000);
+            pending_t e = { .due_ns = now_ns() + m.service_ns,
+                            .dev = m.dev, .pid = m.pid,
+                            .req_id = m.req_id, .t_start_ns = m.t_start_ns };
+            heap_push(e);
+        }
+        if(r == sizeof(m) && m.msg_type == MSG_TICK){
+            // --tickless: próximo IRQ0 no instante absoluto pedido, depois
+            // a cada service_ns; t_start_ns = 0 desarma
+            struct itimerspec its = {0};
+            its.it_value.tv_sec = m.t_start_ns / 1000000000LL;
+            its.it_value.tv_nsec = m.t_start_ns % 1000000000LL;
+            its.it_interval.tv_sec = m.service_ns / 1000000000LL;
+            its.it_interval.tv_nsec = m.service_ns % 1000000000LL;
+            timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
         }
     }
     return 0;
@@ -0,0 +1,98 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef KAIO_H
+#define KAIO_H
+
+/* I/O assíncrono dos apps (passos aread/awrite/wait, ver workload.h).
+   O app submete pedidos sem se bloquear (MSG_AIO_SUBMIT) e segue
+   calculando; o kernel conclui cada pedido por conta própria e soma 1 ao
+   contador `done` da vaga do app, numa área compartilhada (memfd herdado
+   no exec, --aio=<fd>,<slot>), um contador por linha de cache.
+
+   Poll: o app lê o contador, sem syscall. Wait: se o contador ainda não
+   chegou ao alvo, o app pede MSG_AIO_WAIT com o alvo e para como numa
+   SYSCALL; o kernel o libera quando o contador alcançar o alvo (ou na
+   hora, se a conclusão chegou entre a leitura e o pedido). Só o kernel
+   escreve no contador.
+
+   Sem portão (--switch signal), o app não se para depois do AIO_WAIT:
+   dorme num futex no contador (kaio_wait) até o kernel publicar o alvo
+   ou pará-lo com SIGSTOP, sem girar na CPU. O app marca `waiting` antes
+   de olhar o contador uma última vez; o kernel publica e, se viu a marca,
+   acorda (o par escrita-então-leitura dos dois lados é seq_cst, então
+   nenhum dos dois perde o outro). Header-only, usado por kernel_sim.c e
+   app.c. */
+
+#include "common.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+typedef struct {
+    _Atomic uint32_t done;     // pedidos assíncronos concluídos
+    _Atomic uint32_t waiting;  // app dormindo (ou prestes a) no futex de done
+    char _pad[56];
+} kaioslot_t;
+
+// Cria a área com n contadores zerados (kernel); NULL em erro
+static inline kaioslot_t *kaio_create(int n, int *fd_out)
+{
+    size_t bytes = (size_t)n * sizeof(kaioslot_t);
+    int fd = memfd_create("ksim-aio", 0);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, (off_t)bytes) < 0) { close(fd); return NULL; }
+    kaioslot_t *v = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (v == MAP_FAILED) { close(fd); return NULL; }
+    *fd_out = fd;
+    return v;
+}
+
+// Mapeia a área herdada e devolve a vaga `slot` (apps)
+static inline kaioslot_t *kaio_attach(int fd, int slot)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < (size_t)(slot + 1) * sizeof(kaioslot_t))
+        return NULL;
+    kaioslot_t *v = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return v == MAP_FAILED ? NULL : &v[slot];
+}
+
+// Sem FUTEX_PRIVATE_FLAG: a palavra é compartilhada entre processos
+static inline void kaio_futex(_Atomic uint32_t *w, int op, uint32_t val)
+{
+    syscall(SYS_futex, (uint32_t *)w, op, val, NULL, NULL, 0);
+}
+
+// Kernel: publica a contagem de concluídos da vaga; acorda o app só se
+// ele marcou que dorme
+static inline void kaio_publish(kaioslot_t *s, uint32_t done)
+{
+    atomic_store(&s->done, done);
+    if (atomic_load(&s->waiting) && atomic_exchange(&s->waiting, 0))
+        kaio_futex(&s->done, FUTEX_WAKE, INT_MAX);
+}
+
+// App: poll (pedidos assíncronos concluídos até agora)
+static inline uint32_t kaio_poll(kaioslot_t *s)
+{
+    return atomic_load_explicit(&s->done, memory_order_acquire);
+}
+
+// App: dorme até o contador chegar a target
+static inline void kaio_wait(kaioslot_t *s, uint32_t target)
+{
+    for (;;) {
+        atomic_store(&s->waiting, 1);
+        uint32_t v = atomic_load(&s->done);
+        if (v >= target) return;
+        kaio_futex(&s->done, FUTEX_WAIT, v);
+    }
+}
+
+#endif
@@ -2,14 +2,35 @@
 // Giovana Nogueira 2220372    
    
 #include "common.h"
+#include "ptable.h"
+#include "msgring.h"
+#include "park.h"
+#include "kaio.h"
+#include "cqring.h"
+#include "trace.h"
+#include "chrome.h"
+#include "workload.h"
+#include "zygote.h"
+#include "task.h"
+#include "kstat.h"
+#include "work.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <getopt.h>
+#include <spawn.h>
 #include <errno.h>
 #include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/timerfd.h>
+#include <sys/stat.h>
+#include <sched.h>
 #include <time.h>
 
 /* Códigos ANSI apenas para colorir os logs e facilitar leitura. */
@@ -23,7 +44,7 @@
 
 // Tabela de processos (PCB) e contagem de processos spawnados
 /* ====== Estado global ====== */
-static pcb_t procs[MAX_APPS];
+static ptable_t pt;       // PCBs + índice PID->PCB (ver ptable.h)
 static int nprocs = 0;
 
 // Pipes de IPC
@@ -33,411 +54,2783 @@ static int fd_app_r = -1, fd_app_w = -1; // app->kernel (kernel lê r; apps escr
 static int fd_ic_r  = -1, fd_ic_w  = -1; // kernel->IC   (IC lê r; kernel escreve w)
 static pid_t ic_pid = -1;
 
-/* flags de sinal */
-static volatile sig_atomic_t got_irq0 = 0; // timeslice
-static volatile sig_atomic_t got_irq1 = 0; // I/O terminado
-static volatile sig_atomic_t got_sysc = 0; // notificação para drenar pipe
-
-/* ====== Fila de prontos (Round-Robin FIFO) ====== */
-static pid_t rq[MAX_APPS];
-static int rq_head = 0, rq_tail = 0, rq_count = 0;
-
-// PID atualmente em execução (RUNNING), ou -1 se CPU ociosa
-static pid_t current = -1;
-
-// ====== Fila de BLOQUEADOS por I/O ======
-// io_q guarda a ordem de chegada; io_busy/io_serving indicam serviço ativo
-/* Fila de bloqueados por I/O e quem está em serviço */
-static pid_t io_q[MAX_APPS];
-static int io_head = 0, io_tail = 0, io_count = 0;
-static int io_busy = 0;
-static pid_t io_serving = -1;
+// Transporte app->kernel selecionável (--ipc): pipe + SIGALRM (padrão)
+// ou anel em memória compartilhada com campainha eventfd (msgring.h)
+enum { IPC_PIPE = 0, IPC_SHM = 1 };
+static int ipc_mode = IPC_PIPE;
+static msgring_t *ring = NULL;
+static int ring_fd = -1;   // memfd do anel (herdado pelos apps)
+static int bell_fd = -1;   // eventfd da campainha
+
+// Troca de contexto selecionável (--switch): SIGSTOP/SIGCONT (padrão) ou
+// portões de estacionamento com futex em memória compartilhada (park.h),
+// um por vaga de processo, indexados por pcb_t.slot
+enum { SW_SIGNAL = 0, SW_PARK = 1 };
+static int switch_mode = SW_SIGNAL;
+static parkslot_t *park = NULL;
+static int park_fd = -1;   // memfd dos portões (herdado pelos apps)
+
+// I/O assíncrono (kaio.h): contador de concluídos de cada vaga, lido
+// pelo app sem syscall (no --des, em des_app_t.aio_done)
+static kaioslot_t *kaio = NULL;
+static int kaio_fd = -1;
+
+// Criação dos apps (--spawn), sempre no instante da chegada:
+//  - fork    fork + exec (padrão); copia a tabela de páginas do kernel
+//  - posix   posix_spawn (clone com CLONE_VM|CLONE_VFORK + exec, sem cópia)
+//  - pool    reserva de zigotos já executados (zygote.h); admitir é só
+//            escrever a tarefa na vaga. A reserva é reabastecida com
+//            posix_spawn, no máximo POOL_BATCH por rodada do loop
+enum { SP_FORK = 0, SP_POSIX = 1, SP_POOL = 2 };
+static const char *const spawn_names[] = {"fork", "posix", "pool"};
+static int spawn_mode = SP_FORK;
+static posix_spawnattr_t spawn_attr;
+static sigset_t app_mask;      // máscara de sinais dos filhos (a de antes do signalfd)
+static zygslot_t *zyg = NULL;
+static int zyg_fd = -1;        // memfd das vagas (herdado pelos apps)
+typedef struct { pid_t pid; int slot, pidfd; } zygote_t;
+static zygote_t *pool = NULL;
+static int pool_n = 0, pool_target = 32;   // zigotos prontos / --pool
+static long pool_miss = 0;     // chegadas sem zigoto livre (criadas direto)
+#define POOL_BATCH  8          // zigotos criados por rodada do loop
+#define ADMIT_BATCH 64         // chegadas admitidas por rodada do loop
+
+// Vagas de processo (portão e zigoto): pilha de livres, devolvidas
+// quando o app termina
+static int *slot_free = NULL;
+static int nslot_free = 0;
+
+// Custo da criação no loop do kernel (throughput do caminho de spawn)
+static long spawn_count = 0;
+static long long spawn_ns = 0, spawn_max_ns = 0;
+static long long admit_max_ns = 0;   // rodada de admissão mais longa
+
+// Fila de conclusões IC->kernel (cqring.h); IRQ1 só avisa que há entradas
+static cqring_t *cq = NULL;
+static int cq_fd = -1;
+static uint32_t next_req_id = 1;
+
+// Espera única do kernel: epoll sobre o pipe de apps, os pidfds dos
+// filhos e um signalfd que recebe IRQ0/IRQ1/SIGALRM (sinais bloqueados,
+// lidos como dados)
+static int epfd = -1;
+static int sfd  = -1;
+static sigset_t kmask;
+
+// Término dos filhos: um pidfd por processo na mesma espera, legível
+// quando ele sai; colhe exatamente esse filho (waitid P_PIDFD), uma vez.
+// Sem pidfd (Linux < 5.3), SIGCHLD pelo signalfd e waitpid em laço.
+static int use_pidfd = 0;
+#define EV_PIDFD (1ULL << 63)   // epoll_event.data de um pidfd: EV_PIDFD | pid
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+/* eventos pendentes (preenchidos a partir do signalfd) */
+static int got_irq0 = 0; // timeslice
+static int got_irq1 = 0; // I/O terminado
+static int got_sysc = 0; // notificação para drenar pipe
+static int got_chld = 0; // algum filho terminou
+
+/* ====== Fila de prontos (estruturas das políticas) ====== */
+// Heap de mínimo de PCBs (índices na tabela) ordenado por (skey, seq);
+// usado pelas políticas de prioridade, stride e CFS
+typedef struct {
+    int *v;
+    int  n, cap;
+} pheap_t;
+
+#define MLFQ_LEVELS 3
+#define MLFQ_BOOST  20   // a cada 20 ticks todos voltam ao nível 0
+
+// Fila de prontos de uma CPU. Guarda as estruturas de todas as políticas;
+// só as da política ativa são usadas.
+typedef struct {
+    pqueue_t fifo;                 // RR e loteria
+    pqueue_t lvl[MLFQ_LEVELS];     // MLFQ (0 = mais prioritário)
+    pheap_t  heap;                 // prioridade, stride, CFS
+    int       count;               // prontos nesta fila
+    int       boost_ticks;         // MLFQ: ticks desde o último boost
+    long long vclock;              // stride: passe global | CFS: min_vruntime
+} runq_t;
+
+// Interface de política: mesma PCB e mesmos ganchos de evento para todas.
+//  enqueue/pick/remove mantêm a estrutura de prontos;
+//  charge: `ns` de CPU consumidos pelo processo em execução;
+//  tick:   IRQ0 com `cur` rodando — retorna 1 para preemptar;
+//  block/wake/exit: transições de estado do processo.
+typedef struct {
+    const char *name;
+    void   (*enqueue)(runq_t *q, pcb_t *p);
+    pcb_t *(*pick)(runq_t *q);
+    void   (*remove)(runq_t *q, pcb_t *p);
+    void   (*charge)(runq_t *q, pcb_t *p, long long ns);
+    int    (*tick)(runq_t *q, pcb_t *cur);
+    void   (*block)(runq_t *q, pcb_t *p);
+    void   (*wake)(runq_t *q, pcb_t *p);
+    void   (*exit)(runq_t *q, pcb_t *p);
+} sched_policy_t;
+static const sched_policy_t *sched;
+
+// Escalas de tempo (--quantum-ms, --work-ms, --io-ms, --time-scale), já
+// divididas pelo fator de escala: com --time-scale 100 tudo corre 100x
+// mais rápido e as proporções entre quantum, PC e I/O se mantêm.
+static double    time_scale = 1.0;
+static long long quantum_ns = 1000000000LL;   // time-slice (período do IRQ0)
+static long long work_ns    = 1000000000LL;   // duração de um PC dos apps
+static int stall_limit = 5;  // IRQ0 sem progresso antes do NUDGE (>= 5 PCs)
+static int log_ms = 0;       // logs com milissegundos (escalas abaixo de 1 s)
+static long nswitch = 0;     // DISPATCHes (trocas de contexto)
+static long npreempt = 0;    // PREEMPTs e NUDGEs
+
+// Rajadas de CPU: o kernel mede a CPU que cada processo usa entre um
+// I/O e outro e mantém a média exponencial (peso BURST_ALPHA para a
+// última rajada). A estimativa ordena o sjf/srtf e, com --adaptive, dá a
+// fatia de cada dispatch: tantos ticks quanto a rajada esperada (ou a já
+// consumida, se maior), de 1 a ADQ_MAX_TICKS. Quem bloqueia cedo nem
+// chega ao fim da fatia; quem é CPU-bound deixa de ser preemptado a cada
+// tick. Vale para rr, lottery, sjf e srtf (as demais já têm fatia própria).
+#define BURST_ALPHA   0.5
+#define ADQ_MAX_TICKS 8
+static int adaptive = 0;
+
+// Trabalho dos apps (--work, work.h). Com spin/mem o PC gasta CPU de
+// verdade (work_iters iterações, calibradas no boot para durar work_ns) e
+// a política é cobrada pela CPU que o processo usou de fato no trecho,
+// lida no relógio de CPU dele (clock_getcpuclockid), e não pelo tempo de
+// parede em RUNNING, que inclui a CPU que o host deu a outros (kernel, IC,
+// apps de outros núcleos na mesma CPU real). A CPU total de cada processo
+// vem do rusage do wait; a do kernel e a do IC, dos relógios de processo.
+static int work_mode = WORK_SLEEP;
+static long long work_iters = 0;
+static long long kcpu_boot_ns = 0;   // CPU do kernel até o BOOT (calibração, reserva)
+
+// Tickless (--tickless), como o NO_HZ do Linux: o IRQ0 só é programado
+// quando pode mudar alguma coisa.
+//   TK_OFF    nenhum núcleo rodando: timer parado, o kernel dorme até o
+//             próximo evento real (I/O, mensagem, chegada)
+//   TK_WATCH  só processos sozinhos no núcleo: o tick nunca preempta;
+//             um IRQ0 a cada stall_limit quanta, só para o vigia de stall
+//   TK_HZ     algum núcleo com disputa: IRQ0 a cada quantum
+// Os ticks continuam na grade tick_next + k*quantum do modo periódico. Os
+// de processos sozinhos que não viraram interrupção são repostos no início
+// da rodada seguinte (tick_catch_up), com a CPU cobrada até o instante de
+// cada um: a política vê a mesma sequência de ticks e decide igual.
+enum { TK_OFF, TK_WATCH, TK_HZ };
+static int tickless = 0;
+static int tick_mode = -1;         // modo programado no timer do IC
+static long long tick_next = 0;    // próximo tick da grade ainda não tratado
+static long tick_irqs = 0;         // IRQ0 entregues
+static long tick_replayed = 0;     // ticks tratados sem interrupção
+static long tick_skipped = 0;      // ticks com todos os núcleos ociosos
+
+// ====== CPUs simuladas (--cpus) ======
+// Cada núcleo tem seu processo em execução (RUNNING, ou -1 se ocioso), sua
+// fila de prontos e seu vigia de stall. Núcleo ocioso rouba trabalho do
+// mais carregado. Os apps de um núcleo são fixados numa CPU real, então
+// com --cpus > 1 vários apps executam de fato em paralelo.
+typedef struct {
+    pid_t  current;
+    runq_t rq;
+    int    stall_ticks;       // quantos IRQ0 seguidos sem progresso do current
+    int    last_progress_pc;  // último PC observado do current
+    int    host_cpu;          // CPU real correspondente
+    long long busy_ns;        // tempo com algum processo em RUNNING
+    long long progress_cpu_ns; // CPU medida do current no último progresso
+} cpu_t;
+static cpu_t *cpus = NULL;
+static int ncpus = 1;
+
+// ====== Dispositivos de I/O (D1..Dn) ======
+// Cada dispositivo tem sua fila de pedidos (ordem de chegada), tempo de
+// serviço e um slot de serviço em andamento (busy/serving). Um pedido
+// vem de uma SYSCALL (o processo fica bloqueado até a conclusão) ou de
+// uma submissão assíncrona (kaio.h; o processo segue e pode ter vários
+// em voo). Os pedidos ficam num vetor com lista de livres e as filas
+// são intrusivas por índice, como as de PCB em ptable.h.
+//
+// Escalonador de disco (--disk-sched). Sem a opção, cada pedido leva o
+// --io-ms (proporcional ao tamanho), em ordem de chegada, como no
+// enunciado. Com ela, o dispositivo é um disco de WL_DISK_BYTES: serviço
+// = seek (cresce com a raiz da distância da cabeça; --io-ms de ponta a
+// ponta) + transferência (--io-ms/DISK_XFER_DIV por 4k). O escalonador
+// escolhe o próximo pedido pela posição da cabeça e junta a ele os
+// pedidos vizinhos do mesmo tipo na fila (até DISK_MERGE_MAX) num serviço
+// só; a conclusão libera todos.
+//   fifo      ordem de chegada
+//   sstf      o mais próximo da cabeça
+//   scan      elevador (LOOK): segue num sentido até acabar, depois volta
+//   clook     só subindo; no fim volta ao menor endereço
+//   deadline  clook, mas um pedido que passou do prazo (leitura
+//             DISK_READ_EXPIRE, escrita DISK_WRITE_EXPIRE vezes o
+//             --io-ms) vai primeiro, leituras antes
+enum { DS_NONE, DS_FIFO, DS_SSTF, DS_SCAN, DS_CLOOK, DS_DEADLINE };
+static const char *const disk_names[] = {"fixo", "fifo", "sstf", "scan", "clook", "deadline"};
+static int disk_sched = DS_NONE;
+#define DISK_SEEK_MIN     0.05          // seek ao vizinho, fração do de ponta a ponta
+#define DISK_XFER_DIV     100
+#define DISK_MERGE_MAX    (512 * 1024)
+#define DISK_READ_EXPIRE  25
+#define DISK_WRITE_EXPIRE 125
+
+typedef struct {
+    pid_t pid;
+    int   rw;              // 0 = READ, 1 = WRITE
+    int   size;            // bytes (0 = um pedido padrão)
+    long long addr;        // endereço (--disk-sched)
+    long long submit_ns;   // instante da submissão (latência, deadline)
+    int   async;           // MSG_AIO_SUBMIT: conclusão não acorda o processo
+    int   next, prev;      // fila do dispositivo (-1 = fim); next: lista de livres
+} ioreq_t;
+static ioreq_t *ioreqs = NULL;
+static int ioreq_cap = 0, ioreq_free = -1;
+
+typedef struct {
+    int head, tail;        // índices em ioreqs (-1 = vazia)
+    int count;
+} ioq_t;
+
+typedef struct {
+    ioq_t q;
+    int   busy;
+    int   serving;         // pedido em serviço (-1 = o dono finalizou)
+    int   *batch;          // pedidos juntados ao em serviço (-1 = saiu)
+    int   nbatch, batch_cap;
+    long long service_ns;  // duração de cada I/O neste dispositivo
+    long long started_ns;  // início do serviço atual (CLOCK_MONOTONIC)
+    uint32_t req_id;       // pedido em serviço (casado com a conclusão do IC)
+    long long busy_ns;     // tempo total em serviço
+    int   nreq;            // pedidos atendidos
+    long long bytes;       // bytes transferidos
+    long long head;        // --disk-sched: cabeça (fim do último pedido)
+    int   dir;             // scan: sentido da varredura (+1 / -1)
+    int   nmerged;         // pedidos atendidos junto com outro
+    long long seek_ns;     // tempo total de seek
+    double *lat;           // latência de cada pedido (SYSCALL -> conclusão), s
+    int   nlat, lat_cap;
+} device_t;
+static device_t *devs = NULL;
+static int ndevs = 1;
 
 /* Contagem de finalizados para critério de parada */
 static int finished_count = 0;
 
-/* Anti-stall (quando só há 1 pronto e ele “não anda”) */
-static int stall_ticks = 0;        // quantos IRQ0 seguidos sem progresso do current
-static int last_progress_pc = -1;  // último PC observado do current
+/* Rodadas do loop principal (para medir o custo do próprio kernel) */
+static long loop_rounds = 0;
 
 /* Tempo base para logs */
-static time_t t0;
+static long long boot_ns;
+
+// Log de eventos: renderizado ao vivo em stdout ou, com --trace, gravado
+// como registros binários no anel de trace.h (sem printf no loop)
+static tracer_t tracer;
+static int tracing = 0;
+static const char *trace_path = NULL;
+static trace_hdr_t log_hdr;
+static chrome_t chrome;                 // --chrome: linha do tempo (chrome.h)
+static const char *chrome_path = NULL;
+
+// ====== Modo de eventos discretos (--des) ======
+// Sem fork, sleep nem sinais: os apps são simulados dentro do kernel e o
+// tempo é virtual, avançado de evento em evento (fila de prioridade por
+// instante). As rotinas de escalonamento, filas e transições de PCB são
+// as mesmas do modo com processos reais; só mudam o relógio (now_ns) e
+// as ações sobre o processo (proc_stop/proc_cont/is_alive).
+enum { EV_TICK, EV_IO_DONE, EV_APP_STEP, EV_APP_EXIT, EV_ARRIVE };
+typedef struct {
+    long long t;                 // instante virtual
+    unsigned long long seq;      // desempate: ordem de agendamento
+    int   type;
+    pid_t pid;
+    cqe_t cqe;                   // EV_IO_DONE
+} des_ev_t;
+// App simulado. Como a espera de app.c, o PC termina work_ns depois do
+// STATUS mesmo que o app seja parado no meio (o relógio de parede corre
+// durante o SIGSTOP); parado, ele só segue no próximo CONT.
+typedef struct {
+    int   pc;
+    wl_cur_t cur;          // posição no programa (workload.h)
+    int   aio_sub;         // pedidos assíncronos submetidos
+    int   aio_done;        // concluídos (o contador de kaio.h)
+    int   need_advance;    // próximo CONT começa um novo PC (voltou de I/O)
+    int   running;
+    int   step_due;        // PC terminou com o app parado
+    int   exited;
+} des_app_t;
+static int des = 0;
+static long long vnow = 0;          // relógio virtual (ns desde o boot)
+static des_ev_t *des_q = NULL;      // heap de mínimo por (t, seq)
+static int des_n = 0, des_cap = 0;
+static unsigned long long des_seq = 0;
+static long des_events = 0;
+static int des_tick_posted = 1;     // --tickless: há um EV_TICK agendado
+static des_app_t *des_apps = NULL;  // indexado por pcb_t.app
+
+// --coro: cada app é uma corrotina (task.h) que roda o laço de app.c no
+// próprio kernel e devolve o controle a cada STATUS ou pedido de I/O.
+// Relógio, eventos e escalonamento são os do --des; a corrotina só
+// substitui o app simulado (des_next) como fonte das mensagens.
+typedef struct {
+    task_t  t;
+    appmsg_t msg;      // mensagem entregue no último ponto de parada
+    int     app;
+} coro_app_t;
+static int coro = 0;
+static coro_app_t *coros = NULL;      // indexado por pcb_t.app
+static coro_app_t *coro_self = NULL;  // tarefa sendo retomada
+static char *coro_stacks = NULL;      // arena de pilhas (task.h)
+static long coro_resumes = 0;
+static long long coro_ns = 0;         // tempo real dentro das retomadas
+
+// ====== Carga e chegadas (--workload) ======
+// Programa, chegada, peso e afinidade de cada app (workload.h); sem
+// --workload, os programas fixos do enunciado, todos chegando no boot.
+// Cada app é criado (--spawn) e entra na fila de prontos (SPAWN) no
+// instante da sua chegada: evento EV_ARRIVE no --des, timerfd na espera
+// do kernel no modo real.
+static wl_app_t *wload = NULL;
+static int wload_cap = 0;
+static const char *workload_path = NULL;
+static int napps_total = 0;
+static int *arr_order = NULL;    // índices dos apps por instante de chegada
+static int arr_next = 0;         // próximo de arr_order a chegar
+static int arr_fd = -1;          // timerfd da próxima chegada (modo real)
+static int got_arr = 0;
+
+// Admissão em tempo de execução (--ctl): FIFO de comandos, uma linha cada
+//   spawn <nome> <atraso_ms> <passos...>   novo app, chega em agora + atraso
+//   end                                    fim das admissões: o kernel
+//                                          encerra quando todos terminarem
+static int ctl_slots = 1024;     // --ctl-slots: vagas extras para apps do --ctl
+static const char *ctl_path = NULL;
+static int ctl_fd = -1;
+static int ctl_made = 0;         // o FIFO foi criado por nós (remover no fim)
+static int ctl_open = 0;         // ainda aceita apps
+static char ctl_buf[4096];
+static size_t ctl_len = 0;
+static int got_ctl = 0;
+
+/* Relatório de métricas (--report-json / --report-csv) */
+static const char *report_json = NULL;
+static const char *report_csv = NULL;
+static long long end_ns;     // instante em que o último app terminou
+
+/* Retrato ao vivo (--stats, kstat.h) */
+static const char *stats_path = NULL;
+static kstat_t *kst = NULL;
+static long long kst_last_ns = 0;   // última publicação (CLOCK_MONOTONIC)
 
 /* ==== PROTÓTIPOS ==== */
 static void rq_push(pid_t p);
-static int  rq_pop(pid_t *p);
-static void io_push(pid_t p);
-static int  io_pop(pid_t *p);
+static void des_post(const des_ev_t *e);
+static void admit_arrivals(void);
+static void pool_forget(pid_t pid);
+static void reap_pidfd(pid_t pid);
+static int  pool_fill(int max);
+static void pool_drain(void);
+static void ctl_read(void);
+static void kev(int type, int cpu, pid_t pid, int a, int b, long long x, long long y);
 
 /* ====== Helpers ====== */
+static long long real_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Relógio do escalonador: real ou, no modo --des, virtual
+static long long now_ns(void)
+{
+    return des ? vnow : real_ns();
+}
+
+// Instante do log: ns desde o boot no relógio do kernel
+static long long log_ns(void)
+{
+    return now_ns() - (des ? 0 : boot_ns);
+}
+
+// Segundos decorridos desde o boot
+static long log_secs(void)
+{
+    return (long)(log_ns() / 1000000000LL);
+}
+
+// Prefixo das linhas fora do fluxo de eventos (BOOT, métricas, fim);
+// os eventos passam por kev() e trace_render()
 static void log_ts_prefix(void)
 {
-    // Prefixa cada linha de log com segundos decorridos desde o boot (t0)
-    time_t now = time(NULL);
-    printf("[%3lds] ", (long)(now - t0));
-    fflush(stdout);
+    if (log_ms) printf("[%8.3fs] ", log_ns() / 1e9);
+    else printf("[%3lds] ", log_secs());
+}
+
+// Busca o PCB pelo PID; retorna NULL se não encontrado
+static pcb_t *bypid(pid_t pid)
+{
+    return pt_get(&pt, pid);
+}
+
+// Resolve PID -> nome curto (A1..An) para logs
+static const char *name_of(pid_t pid)
+{
+    pcb_t *p = bypid(pid);
+    return p ? p->name : "?";
+}
+
+// Troca o estado do processo e contabiliza o tempo passado no estado
+// anterior (CPU, espera na fila de prontos ou bloqueio por I/O)
+static void set_state(pcb_t *p, pstate_t st)
+{
+    long long now = now_ns(), dt = now - p->t_state;
+    switch (p->st) {
+    case ST_RUNNING:
+        p->cpu_ns += dt;
+        if (p->cpu >= 0) cpus[p->cpu].busy_ns += dt;
+        break;
+    case ST_READY:   p->wait_ns += dt; break;
+    case ST_BLOCKED: p->blocked_ns += dt; break;
+    default: break;
+    }
+    if (st == ST_RUNNING) {
+        p->ndispatch++;
+        if (p->t_first_run < 0) p->t_first_run = now;
+    }
+    if (st == ST_FINISHED) p->t_finish = now;
+    p->st = st;
+    p->t_state = now;
+}
+
+// Coloca um FD em modo não-bloqueante (usado em fd_app_r)
+static void set_nonblock(int fd)
+{
+    int fl = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+}
+
+/* === Helpers de vida e limpeza de filas === */
+static void des_cont(pid_t pid);
+static void des_stop(pid_t pid);
+
+// O processo ainda não foi dado como FINISHED. Sem syscall: o término
+// chega pelo pidfd (ou SIGCHLD) na espera do kernel; até lá, um app que
+// acabou de sair só recebe um STOP/CONT inócuo (é um zumbi, não um PID
+// reciclado: só o kernel o colhe).
+static int is_alive(pid_t pid) {
+    pcb_t *p = bypid(pid);
+    if (des) return p && !des_apps[p->app].exited;
+    return p && p->st != ST_FINISHED;
+}
+
+// Sinal pelo pidfd (não erra de processo se o PID for reusado); sem
+// pidfd (-1), pelo PID
+static void pidfd_signal(pid_t pid, int pidfd, int sig)
+{
+#ifdef SYS_pidfd_send_signal
+    if (pidfd >= 0) {
+        syscall(SYS_pidfd_send_signal, pidfd, sig, NULL, 0);
+        return;
+    }
+#endif
+    kill(pid, sig);
+}
+
+// Sinal ao processo: pelo pidfd, se houver
+static void proc_signal(pid_t pid, int sig)
+{
+    pcb_t *p = bypid(pid);
+    pidfd_signal(pid, p ? p->pidfd : -1, sig);
+}
+
+// Para / retoma o processo: SIGSTOP/SIGCONT, portão (park.h) ou, no
+// --des, o app simulado
+static void proc_stop(pid_t pid)
+{
+    if (des) des_stop(pid);
+    else if (park) park_stop(&park[bypid(pid)->slot].gate);
+    else proc_signal(pid, SIGSTOP);
+}
+static void proc_cont(pid_t pid)
+{
+    if (des) des_cont(pid);
+    else if (park) park_cont(&park[bypid(pid)->slot].gate);
+    else proc_signal(pid, SIGCONT);
+}
+
+/* ====== Heap de PCBs ====== */
+static int ph_less(const pcb_t *a, const pcb_t *b)
+{
+    return a->skey < b->skey || (a->skey == b->skey && a->seq < b->seq);
+}
+static void ph_set(pheap_t *h, int i, int idx)
+{
+    h->v[i] = idx;
+    pt.v[idx].heap_pos = i;
+}
+static void ph_up(pheap_t *h, int i)
+{
+    int idx = h->v[i];
+    while (i > 0 && ph_less(&pt.v[idx], &pt.v[h->v[(i - 1) / 2]])) {
+        ph_set(h, i, h->v[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+    ph_set(h, i, idx);
+}
+static void ph_down(pheap_t *h, int i)
+{
+    int idx = h->v[i];
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= h->n) break;
+        if (c + 1 < h->n && ph_less(&pt.v[h->v[c + 1]], &pt.v[h->v[c]])) c++;
+        if (!ph_less(&pt.v[h->v[c]], &pt.v[idx])) break;
+        ph_set(h, i, h->v[c]);
+        i = c;
+    }
+    ph_set(h, i, idx);
+}
+static void ph_push(pheap_t *h, pcb_t *p)
+{
+    static unsigned long long seqctr = 0;
+    if (h->n == h->cap) {
+        h->cap = h->cap ? 2 * h->cap : 64;
+        h->v = realloc(h->v, (size_t)h->cap * sizeof(int));
+        if (!h->v) { perror("heap"); exit(1); }
+    }
+    p->seq = ++seqctr; // desempate FIFO entre chaves iguais
+    h->v[h->n++] = p->idx;
+    ph_up(h, h->n - 1);
+}
+static void ph_remove(pheap_t *h, pcb_t *p)
+{
+    int i = p->heap_pos;
+    if (i < 0 || i >= h->n || h->v[i] != p->idx) return;
+    p->heap_pos = -1;
+    int last = h->v[--h->n];
+    if (i == h->n) return;
+    ph_set(h, i, last);
+    ph_up(h, i);
+    ph_down(h, pt.v[last].heap_pos);
+}
+static pcb_t *ph_top(pheap_t *h)
+{
+    return h->n ? &pt.v[h->v[0]] : NULL;
+}
+static pcb_t *ph_pop(pheap_t *h)
+{
+    pcb_t *p = ph_top(h);
+    if (p) ph_remove(h, p);
+    return p;
+}
+
+/* ====== Políticas de escalonamento ====== */
+static void nop_hook(runq_t *q, pcb_t *p) { (void)q; (void)p; }
+static void nop_charge(runq_t *q, pcb_t *p, long long ns) { (void)q; (void)p; (void)ns; }
+
+/* --- Rajadas de CPU (estimativa e fatia adaptativa) --- */
+// CPU já usada na rajada atual (inclui o trecho cobrado até o último tick)
+static long long burst_sofar(const pcb_t *p)
+{
+    long long ns = p->cpu_ns - p->burst_cpu0;
+    if (p->st == ST_RUNNING && p->run_start_ns > p->t_state) ns += p->run_start_ns - p->t_state;
+    return ns;
+}
+
+// Quanto falta da rajada atual: o que a média prevê, mas nunca menos do
+// que já rodou (uma rajada longa tende a continuar longa)
+static long long burst_left(const pcb_t *p)
+{
+    long long sofar = burst_sofar(p), left = p->burst_est - sofar;
+    return left > sofar ? left : sofar;
+}
+
+// Fim de rajada (o processo bloqueou em I/O): atualiza a média
+static void burst_end(pcb_t *p)
+{
+    long long b = p->cpu_ns - p->burst_cpu0;
+    p->burst_est = p->burst_est ? (long long)(BURST_ALPHA * b + (1 - BURST_ALPHA) * p->burst_est) : b;
+    p->burst_cpu0 = p->cpu_ns;
+}
+
+// Fatia do dispatch em ticks (--adaptive)
+static int slice_for(const pcb_t *p)
+{
+    long long want = p->burst_est > burst_sofar(p) ? p->burst_est : burst_sofar(p);
+    long long ticks = (want + quantum_ns - 1) / quantum_ns;
+    return ticks < 1 ? 1 : ticks > ADQ_MAX_TICKS ? ADQ_MAX_TICKS : (int)ticks;
+}
+
+// A fatia do processo em execução acabou (sem --adaptive: todo tick)
+static int slice_over(const pcb_t *cur)
+{
+    return !adaptive || cur->slice_used >= cur->slice_target;
+}
+
+/* --- RR: FIFO, preempta a cada tick (ou fim da fatia) se há outro pronto --- */
+static void rr_enqueue(runq_t *q, pcb_t *p) { pq_push(&pt, &q->fifo, p); }
+static pcb_t *rr_pick(runq_t *q) { return pq_pop(&pt, &q->fifo); }
+static void rr_remove(runq_t *q, pcb_t *p) { (void)q; pq_remove(&pt, p); }
+static int rr_tick(runq_t *q, pcb_t *cur) { return q->count > 0 && slice_over(cur); }
+
+/* --- MLFQ: níveis com quantum 1,2,4 ticks; gastou o quantum, desce;
+       boost periódico evita inanição dos níveis de baixo --- */
+static void mlfq_enqueue(runq_t *q, pcb_t *p) { pq_push(&pt, &q->lvl[p->level], p); }
+static pcb_t *mlfq_pick(runq_t *q)
+{
+    for (int l = 0; l < MLFQ_LEVELS; l++)
+        if (q->lvl[l].count) return pq_pop(&pt, &q->lvl[l]);
+    return NULL;
+}
+static int mlfq_tick(runq_t *q, pcb_t *cur)
+{
+    if (++q->boost_ticks >= MLFQ_BOOST) {
+        q->boost_ticks = 0;
+        for (int l = 1; l < MLFQ_LEVELS; l++) {
+            pcb_t *p;
+            while ((p = pq_pop(&pt, &q->lvl[l])) != NULL) {
+                p->level = 0;
+                pq_push(&pt, &q->lvl[0], p);
+            }
+        }
+        cur->level = 0;
+        cur->slice_ticks = 0;
+    }
+    int expired = ++cur->slice_ticks >= (1 << cur->level);
+    if (expired) {
+        if (cur->level < MLFQ_LEVELS - 1) cur->level++;
+        cur->slice_ticks = 0;
+    }
+    int higher = 0;
+    for (int l = 0; l < cur->level && !higher; l++) higher = q->lvl[l].count > 0;
+    return (expired && q->count > 0) || higher;
+}
+static void mlfq_block(runq_t *q, pcb_t *p) { (void)q; p->slice_ticks = 0; }
+
+/* --- Prioridade estática: maior peso primeiro; RR entre iguais --- */
+static void prio_enqueue(runq_t *q, pcb_t *p) { p->skey = -p->weight; ph_push(&q->heap, p); }
+static pcb_t *prio_pick(runq_t *q) { return ph_pop(&q->heap); }
+static void prio_remove(runq_t *q, pcb_t *p) { ph_remove(&q->heap, p); }
+static int prio_tick(runq_t *q, pcb_t *cur)
+{
+    pcb_t *top = ph_top(&q->heap);
+    return top && top->weight >= cur->weight;
+}
+
+/* --- Stride: passe avança stride = STRIDE1/bilhetes por quantum de CPU;
+       roda o menor passe --- */
+#define STRIDE1 (1LL << 20)
+static long long stride_of(const pcb_t *p) { return STRIDE1 / (p->weight * 100); }
+static void stride_enqueue(runq_t *q, pcb_t *p) { p->skey = p->vtime; ph_push(&q->heap, p); }
+static pcb_t *stride_pick(runq_t *q)
+{
+    pcb_t *p = ph_pop(&q->heap);
+    if (p && p->vtime > q->vclock) q->vclock = p->vtime; // passe global
+    return p;
+}
+static void stride_charge(runq_t *q, pcb_t *p, long long ns)
+{
+    (void)q;
+    p->vtime += stride_of(p) * ns / quantum_ns;
+}
+static int stride_tick(runq_t *q, pcb_t *cur)
+{
+    pcb_t *top = ph_top(&q->heap);
+    return top && top->vtime <= cur->vtime;
+}
+static void stride_wake(runq_t *q, pcb_t *p)
+{
+    // quem dormiu não acumula crédito: parte do passe global
+    if (p->vtime < q->vclock) p->vtime = q->vclock;
+}
+
+/* --- Loteria: sorteio ponderado pelos bilhetes a cada quantum --- */
+static unsigned lottery_rng = 12345u;
+static pcb_t *lottery_pick(runq_t *q)
+{
+    long long total = 0;
+    for (int i = q->fifo.head; i >= 0; i = pt.v[i].q_next) total += pt.v[i].weight * 100;
+    if (total == 0) return NULL;
+    lottery_rng ^= lottery_rng << 13;
+    lottery_rng ^= lottery_rng >> 17;
+    lottery_rng ^= lottery_rng << 5;
+    long long win = (long long)(lottery_rng % (unsigned long long)total);
+    for (int i = q->fifo.head; i >= 0; i = pt.v[i].q_next) {
+        win -= pt.v[i].weight * 100;
+        if (win < 0) {
+            pq_remove(&pt, &pt.v[i]);
+            return &pt.v[i];
+        }
+    }
+    return NULL;
+}
+
+/* --- CFS: árvore (heap) ordenada por vruntime; vruntime cresce
+       inversamente ao peso; roda quem recebeu menos CPU ponderada --- */
+static void cfs_enqueue(runq_t *q, pcb_t *p) { p->skey = p->vtime; ph_push(&q->heap, p); }
+static pcb_t *cfs_pick(runq_t *q)
+{
+    pcb_t *p = ph_pop(&q->heap);
+    if (p && p->vtime > q->vclock) q->vclock = p->vtime; // min_vruntime monotônico
+    return p;
+}
+static void cfs_charge(runq_t *q, pcb_t *p, long long ns)
+{
+    (void)q;
+    p->vtime += ns / p->weight;
+}
+static int cfs_tick(runq_t *q, pcb_t *cur)
+{
+    pcb_t *top = ph_top(&q->heap);
+    return top && top->vtime < cur->vtime;
+}
+static void cfs_wake(runq_t *q, pcb_t *p)
+{
+    // crédito de quem dormiu limitado a meio quantum
+    long long floor = q->vclock - quantum_ns / 2;
+    if (p->vtime < floor) p->vtime = floor;
+}
+
+/* --- SJF: a menor rajada estimada primeiro; não preempta (com
+       --adaptive, preempta no fim da fatia) --- */
+static void sjf_enqueue(runq_t *q, pcb_t *p) { p->skey = burst_left(p); ph_push(&q->heap, p); }
+static int sjf_tick(runq_t *q, pcb_t *cur) { return adaptive && q->count > 0 && slice_over(cur); }
+
+/* --- SRTF: como o SJF, mas no tick preempta se um pronto tem menos
+       rajada restante estimada que o atual --- */
+static int srtf_tick(runq_t *q, pcb_t *cur)
+{
+    pcb_t *top = ph_top(&q->heap);
+    return top && (burst_left(top) < burst_left(cur) || sjf_tick(q, cur));
+}
+
+static const sched_policy_t policies[] = {
+    {"rr",      rr_enqueue,     rr_pick,      rr_remove,   nop_charge,    rr_tick,     nop_hook,   nop_hook,    nop_hook},
+    {"mlfq",    mlfq_enqueue,   mlfq_pick,    rr_remove,   nop_charge,    mlfq_tick,   mlfq_block, nop_hook,    nop_hook},
+    {"prio",    prio_enqueue,   prio_pick,    prio_remove, nop_charge,    prio_tick,   nop_hook,   nop_hook,    nop_hook},
+    {"stride",  stride_enqueue, stride_pick,  prio_remove, stride_charge, stride_tick, nop_hook,   stride_wake, nop_hook},
+    {"lottery", rr_enqueue,     lottery_pick, rr_remove,   nop_charge,    rr_tick,     nop_hook,   nop_hook,    nop_hook},
+    {"cfs",     cfs_enqueue,    cfs_pick,     prio_remove, cfs_charge,    cfs_tick,    nop_hook,   cfs_wake,    nop_hook},
+    {"sjf",     sjf_enqueue,    prio_pick,    prio_remove, nop_charge,    sjf_tick,    nop_hook,   nop_hook,    nop_hook},
+    {"srtf",    sjf_enqueue,    prio_pick,    prio_remove, nop_charge,    srtf_tick,   nop_hook,   nop_hook,    nop_hook},
+};
+
+static void runq_init(runq_t *q)
+{
+    memset(q, 0, sizeof(*q));
+    pq_init(&q->fifo);
+    for (int l = 0; l < MLFQ_LEVELS; l++) pq_init(&q->lvl[l]);
+}
+
+/* ==== Helpers de fila de PRONTOS — ignoram PIDs finalizados ===*/
+// Núcleo com menos trabalho (em execução + prontos)
+static int least_loaded_cpu(void)
+{
+    int best = 0, best_load = -1;
+    for (int c = 0; c < ncpus; c++) {
+        int load = cpus[c].rq.count + (cpus[c].current != -1);
+        if (best_load < 0 || load < best_load) { best = c; best_load = load; }
+    }
+    return best;
+}
+
+// Núcleo onde o processo deve esperar: o da afinidade, senão o último em
+// que rodou (cache quente), senão o menos carregado
+static int home_cpu(pcb_t *p)
+{
+    if (p->affinity >= 0) return p->affinity;
+    if (p->cpu >= 0) return p->cpu;
+    return least_loaded_cpu();
+}
+
+static void rq_push(pid_t p)
+{
+    pcb_t *pp = bypid(p);
+    if (!pp || pp->st == ST_FINISHED || pp->on_rq) return; // não enfileira finalizado
+    pp->cpu = home_cpu(pp);
+    pp->on_rq = 1;
+    cpus[pp->cpu].rq.count++;
+    sched->enqueue(&cpus[pp->cpu].rq, pp);
+}
+
+// Processo volta a ficar pronto (chegada ou fim de I/O): gancho wake da
+// política no núcleo de destino e depois a fila
+static void rq_wake(pcb_t *p)
+{
+    p->cpu = home_cpu(p);
+    sched->wake(&cpus[p->cpu].rq, p);
+    rq_push(p->pid);
+}
+
+static pcb_t *rq_take(int c)
+{
+    runq_t *q = &cpus[c].rq;
+    if (q->count == 0) return NULL;
+    pcb_t *p = sched->pick(q);
+    if (p) { p->on_rq = 0; q->count--; }
+    return p;
+}
+
+// Próximo a executar no núcleo `c`: da própria fila ou, se vazia, roubado
+// do núcleo com mais prontos (respeitando afinidade)
+static pcb_t *rq_pick(int c)
+{
+    pcb_t *p = rq_take(c);
+    if (p || ncpus == 1) return p;
+
+    int victim = -1;
+    for (int v = 0; v < ncpus; v++)
+        if (v != c && cpus[v].rq.count > 0 && (victim < 0 || cpus[v].rq.count > cpus[victim].rq.count))
+            victim = v;
+    if (victim < 0) return NULL;
+
+    // fixados em outro núcleo voltam para a fila; no máximo uma volta
+    for (int tries = cpus[victim].rq.count; tries > 0; tries--) {
+        p = rq_take(victim);
+        if (!p) break;
+        if (p->affinity < 0 || p->affinity == c) {
+            p->cpu = c;
+            kev(TR_STEAL, c, p->pid, victim, 0, 0, 0);
+            return p;
+        }
+        p->on_rq = 1;
+        cpus[victim].rq.count++;
+        sched->enqueue(&cpus[victim].rq, p);
+    }
+    return NULL;
+}
+
+static void rq_remove(pcb_t *p)
+{
+    if (!p->on_rq) return;
+    sched->remove(&cpus[p->cpu].rq, p);
+    p->on_rq = 0;
+    cpus[p->cpu].rq.count--;
+}
+
+// Total de prontos em todos os núcleos
+static int ready_total(void)
+{
+    int n = 0;
+    for (int c = 0; c < ncpus; c++) n += cpus[c].rq.count;
+    return n;
+}
+
+static long long clock_ns(clockid_t clk)
+{
+    struct timespec ts;
+    if (clock_gettime(clk, &ts) < 0) return -1;
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Lê o relógio de CPU do processo: CPU do host usada desde a leitura
+// anterior (-1 sem relógio: --des ou processo já colhido)
+static long long cpu_measure(pcb_t *p)
+{
+    long long v = p->clk_ok ? clock_ns(p->clk) : -1;
+    if (v < 0) return -1;
+    long long d = v - p->host_cpu_ns;
+    p->host_cpu_ns = v;
+    return d;
+}
+
+// Processo colhido: a CPU total é a do rusage (inclui o que rodou depois
+// da última leitura); o relógio deixa de valer, o PID pode ser reusado
+static void cpu_final(pcb_t *p, const struct rusage *ru)
+{
+    long long v = (long long)(ru->ru_utime.tv_sec + ru->ru_stime.tv_sec) * 1000000000LL
+                  + (long long)(ru->ru_utime.tv_usec + ru->ru_stime.tv_usec) * 1000LL;
+    if (v > p->host_cpu_ns) p->host_cpu_ns = v;
+    p->clk_ok = 0;
+}
+
+// Cobra da política a CPU usada pelo processo em execução desde a última
+// cobrança (dispatch, tick, bloqueio ou preempção) até o instante t: o
+// tempo em RUNNING ou, com --work spin|mem, a CPU medida no trecho
+static void charge_until(pcb_t *p, long long t)
+{
+    if (t < p->run_start_ns) return; // tick reposto de antes do dispatch
+    long long ns = t - p->run_start_ns, m;
+    if (work_mode != WORK_SLEEP && (m = cpu_measure(p)) >= 0) ns = m;
+    sched->charge(&cpus[p->cpu].rq, p, ns);
+    p->run_start_ns = t;
+}
+
+static void charge_running(pcb_t *p)
+{
+    charge_until(p, now_ns());
+}
+
+/* === Pedidos de I/O e filas dos dispositivos — ordem de chegada (FIFO) === */
+// Tira um pedido da lista de livres (dobra o vetor se preciso)
+static int ioreq_get(void)
+{
+    if (ioreq_free < 0) {
+        int old = ioreq_cap;
+        ioreq_cap = ioreq_cap ? 2 * ioreq_cap : 64;
+        ioreqs = realloc(ioreqs, (size_t)ioreq_cap * sizeof(ioreq_t));
+        if (!ioreqs) { perror("ioreq"); exit(1); }
+        for (int i = ioreq_cap - 1; i >= old; i--) {
+            ioreqs[i].next = ioreq_free;
+            ioreq_free = i;
+        }
+    }
+    int r = ioreq_free;
+    ioreq_free = ioreqs[r].next;
+    return r;
+}
+
+static void ioreq_put(int r)
+{
+    ioreqs[r].pid = -1;
+    ioreqs[r].next = ioreq_free;
+    ioreq_free = r;
+}
+
+static void ioq_push(ioq_t *q, int r)
+{
+    ioreqs[r].next = -1;
+    ioreqs[r].prev = q->tail;
+    if (q->tail >= 0) ioreqs[q->tail].next = r;
+    else q->head = r;
+    q->tail = r;
+    q->count++;
+}
+
+static void ioq_remove(ioq_t *q, int r)
+{
+    ioreq_t *x = &ioreqs[r];
+    if (x->prev >= 0) ioreqs[x->prev].next = x->next;
+    else q->head = x->next;
+    if (x->next >= 0) ioreqs[x->next].prev = x->prev;
+    else q->tail = x->prev;
+    q->count--;
+}
+
+// Enfileira o pedido da mensagem m (SYSCALL ou AIO_SUBMIT) do processo p
+// no dispositivo dev
+static void io_submit(pcb_t *p, const appmsg_t *m, int dev)
+{
+    int r = ioreq_get();
+    ioreqs[r] = (ioreq_t){.pid = p->pid, .rw = m->arg ? 1 : 0, .size = m->size, .addr = m->addr,
+                          .submit_ns = now_ns(), .async = m->msg_type == MSG_AIO_SUBMIT};
+    if (!ioreqs[r].async) p->io_dev = dev;
+    ioq_push(&devs[dev].q, r);
+}
+
+/* === Escalonador de disco (--disk-sched) === */
+static long long disk_dist(long long a, long long b) { return a > b ? a - b : b - a; }
+
+// Prazo vencido do pedido (deadline)
+static int disk_expired(const device_t *d, const ioreq_t *r, long long now)
+{
+    long long ttl = d->service_ns * (r->rw ? DISK_WRITE_EXPIRE : DISK_READ_EXPIRE);
+    return now - r->submit_ns >= ttl;
+}
+
+// C-LOOK: menor endereço >= cabeça; se não há, o menor de todos
+static int disk_clook(device_t *d)
+{
+    int up = -1, low = -1;
+    for (int i = d->q.head; i >= 0; i = ioreqs[i].next) {
+        long long a = ioreqs[i].addr;
+        if (a >= d->head && (up < 0 || a < ioreqs[up].addr)) up = i;
+        if (low < 0 || a < ioreqs[low].addr) low = i;
+    }
+    return up >= 0 ? up : low;
+}
+
+// Próximo pedido a atender na fila de d (-1 se vazia)
+static int disk_pick(device_t *d)
+{
+    int first = d->q.head;
+    if (first < 0) return -1;
+    switch (disk_sched) {
+    case DS_SSTF: {
+        int best = first;
+        for (int i = ioreqs[first].next; i >= 0; i = ioreqs[i].next)
+            if (disk_dist(ioreqs[i].addr, d->head) < disk_dist(ioreqs[best].addr, d->head)) best = i;
+        return best;
+    }
+    case DS_SCAN:
+        for (int tries = 0; tries < 2; tries++) {
+            int best = -1;
+            for (int i = d->q.head; i >= 0; i = ioreqs[i].next) {
+                long long delta = (ioreqs[i].addr - d->head) * d->dir;
+                if (delta >= 0 && (best < 0 || delta < (ioreqs[best].addr - d->head) * d->dir)) best = i;
+            }
+            if (best >= 0) return best;
+            d->dir = -d->dir;   // nada mais neste sentido: volta
+        }
+        return first;
+    case DS_CLOOK:
+        return disk_clook(d);
+    case DS_DEADLINE: {
+        // a fila está em ordem de chegada: o primeiro vencido é o mais antigo
+        long long now = now_ns();
+        int wr = -1;
+        for (int i = d->q.head; i >= 0; i = ioreqs[i].next) {
+            if (!disk_expired(d, &ioreqs[i], now)) continue;
+            if (!ioreqs[i].rw) return i;
+            if (wr < 0) wr = i;
+        }
+        return wr >= 0 ? wr : disk_clook(d);
+    }
+    default:
+        return first;
+    }
+}
+
+// Junta ao pedido `lead` os do mesmo tipo na fila que encostam no
+// intervalo [*lo, *hi) por qualquer lado, até DISK_MERGE_MAX bytes;
+// os juntados saem da fila e vão para d->batch
+static void disk_merge(device_t *d, int lead, long long *lo, long long *hi)
+{
+    d->nbatch = 0;
+    for (int grew = 1; grew && d->q.count > 0;) {
+        grew = 0;
+        for (int i = d->q.head; i >= 0;) {
+            ioreq_t *r = &ioreqs[i];
+            int cur = i;
+            i = r->next;
+            int size = r->size > 0 ? r->size : WL_IO_UNIT;
+            long long end = r->addr + size;
+            if (r->rw != ioreqs[lead].rw) continue;
+            if (end != *lo && r->addr != *hi) continue;
+            if (*hi - *lo + size > DISK_MERGE_MAX) continue;
+            if (end == *lo) *lo = r->addr;
+            else *hi = end;
+            ioq_remove(&d->q, cur);
+            if (d->nbatch == d->batch_cap) {
+                d->batch_cap = d->batch_cap ? 2 * d->batch_cap : 16;
+                d->batch = realloc(d->batch, (size_t)d->batch_cap * sizeof(int));
+                if (!d->batch) { perror("disk"); exit(1); }
+            }
+            d->batch[d->nbatch++] = cur;
+            grew = 1;
+        }
+    }
+}
+
+// Raiz inteira (seek cresce com a raiz da distância; sem libm)
+static long long disk_isqrt(long long v)
+{
+    long long r = 0;
+    for (long long b = 1LL << 30; b > 0; b >>= 1)
+        if ((r + b) * (r + b) <= v) r += b;
+    return r;
+}
+
+// Duração do serviço de [lo, hi): seek até lo + transferência; move a cabeça
+static long long disk_service(device_t *d, long long lo, long long hi)
+{
+    long long dist = disk_dist(lo, d->head) / WL_IO_UNIT;
+    long long seek = 0;
+    if (dist > 0)
+        seek = (long long)(d->service_ns * (DISK_SEEK_MIN + (1 - DISK_SEEK_MIN) *
+                           (double)disk_isqrt(dist) / disk_isqrt(WL_DISK_BYTES / WL_IO_UNIT)));
+    long long xfer = d->service_ns / DISK_XFER_DIV * ((hi - lo + WL_IO_UNIT - 1) / WL_IO_UNIT);
+    d->head = hi;
+    d->seek_ns += seek;
+    return seek + xfer;
+}
+
+/* limpeza de filas */
+// Remove um PID da fila em que estiver (prontos) e descarta seus pedidos
+// de I/O — usado ao FINISH. Só varre os dispositivos se há pedido dele.
+static void queues_remove_pid(pid_t pid) {
+    pcb_t *pp = bypid(pid);
+    if (!pp) return;
+    rq_remove(pp);
+    pq_remove(&pt, pp);
+    if (pp->io_dev < 0 && pp->aio_inflight == 0) return;
+    pp->io_dev = -1;
+    pp->aio_inflight = 0;
+    for (int dv = 0; dv < ndevs; dv++) {
+        device_t *d = &devs[dv];
+        for (int i = d->q.head; i >= 0;) {
+            int cur = i;
+            i = ioreqs[i].next;
+            if (ioreqs[cur].pid != pid) continue;
+            ioq_remove(&d->q, cur);
+            ioreq_put(cur);
+        }
+        if (!d->busy) continue;
+        int live = 0;
+        for (int i = 0; i < d->nbatch; i++) {
+            if (d->batch[i] >= 0 && ioreqs[d->batch[i]].pid == pid) {
+                ioreq_put(d->batch[i]);
+                d->batch[i] = -1;
+            }
+            live += d->batch[i] != -1;
+        }
+        if (d->serving >= 0 && ioreqs[d->serving].pid == pid) {
+            ioreq_put(d->serving);
+            d->serving = -1;
+            if (live) continue;   // o serviço continua para os juntados
+            d->busy = 0;
+            d->busy_ns += now_ns() - d->started_ns;
+        }
+    }
+}
+
+// Quantidade total de pedidos esperando nas filas dos dispositivos
+static int io_pending(void)
+{
+    int n = 0;
+    for (int d = 0; d < ndevs; d++) n += devs[d].q.count + devs[d].busy;
+    return n;
+}
+
+/* ====== Log de eventos ====== */
+// Registra um evento: binário no anel (--trace) ou renderizado em stdout
+static void kev(int type, int cpu, pid_t pid, int a, int b, long long x, long long y)
+{
+    trace_rec_t r = {.t_ns = log_ns(), .type = (uint16_t)type, .cpu = (int16_t)cpu, .pid = pid,
+                     .a = a, .b = b, .rq = (uint32_t)ready_total(), .ioq = (uint32_t)io_pending(),
+                     .x = x, .y = y};
+    if (type == TR_SPAWN) { // nome para o ktrace
+        char nm[MAX_NAME] = {0};
+        snprintf(nm, sizeof(nm), "%s", name_of(pid));
+        memcpy(&r.x, nm, MAX_NAME);
+    }
+    if (chrome.f) chrome_event(&chrome, &r, name_of(pid));
+    if (tracing) trace_push(&tracer, &r, des);
+    else trace_render(stdout, &log_hdr, &r, name_of(pid));
+}
+
+// Inicia a escritora do --trace. Chamado com os sinais do kernel já
+// bloqueados, para que a thread nova os herde bloqueados.
+static void trace_start(void)
+{
+    if (chrome_path && !chrome_open(&chrome, chrome_path)) { perror(chrome_path); exit(1); }
+    if (!trace_path) return;
+    if (!trace_open(&tracer, trace_path, 1 << 16, &log_hdr)) { perror(trace_path); exit(1); }
+    tracing = 1;
+}
+
+static void trace_stop(void)
+{
+    if (chrome.f) {
+        chrome_close(&chrome);
+        log_ts_prefix();
+        printf(C_SCH "CHROME    ~~ linha do tempo em %s (chrome://tracing ou ui.perfetto.dev)" C_RST "\n",
+               chrome_path);
+    }
+    if (!tracing) return;
+    unsigned long long n = atomic_load(&tracer.tail);
+    tracing = 0;
+    trace_close(&tracer);
+    log_ts_prefix();
+    printf(C_SCH "TRACE     ~~ %llu eventos em %s (%llu descartados); veja com ./ktrace %s" C_RST "\n",
+           n, trace_path, (unsigned long long)tracer.dropped, trace_path);
+}
+
+// Escolhe o dispositivo de um pedido: o indicado pelo app (módulo ndevs)
+// ou, se o app não indicou (-1), o de menor fila
+static int pick_device(int want)
+{
+    if (want >= 0) return want % ndevs;
+    int best = 0;
+    for (int d = 1; d < ndevs; d++)
+        if (devs[d].q.count + devs[d].busy < devs[best].q.count + devs[best].busy) best = d;
+    return best;
+}
+
+/* ====== Sinais ====== */
+// Drena o signalfd e converte cada sinal recebido em flag de evento.
+// Sinais padrão coalescem enquanto pendentes, como antes com os handlers.
+static void drain_signalfd(void)
+{
+    struct signalfd_siginfo si[16];
+    for (;;) {
+        ssize_t r = read(sfd, si, sizeof(si));
+        if (r <= 0) break;
+        for (size_t i = 0; i < (size_t)r / sizeof(si[0]); i++) {
+            switch (si[i].ssi_signo) {
+            case SIGUSR1: got_irq0 = 1; tick_irqs++; break;
+            case SIGUSR2: got_irq1 = 1; break;
+            case SIGALRM: got_sysc = 1; break;
+            case SIGCHLD: got_chld = 1; break;
+            }
+        }
+    }
+}
+
+// Bloqueia até o próximo evento (pipe de apps ou sinal); sem timeout,
+// então o kernel não consome CPU enquanto nada acontece. Com trabalho
+// pendente (chegadas em lote, reserva de zigotos), só verifica.
+// No modo shm, avisa os apps (flag `sleeping`) antes de bloquear e
+// desiste de dormir se uma mensagem chegou nesse meio-tempo.
+static void wait_events(int busy)
+{
+    if (ring && !busy && !msgring_prepare_sleep(ring)) return;
+    struct epoll_event ev[8];
+    int n = epoll_wait(epfd, ev, 8, busy ? 0 : -1);
+    if (n < 0 && errno != EINTR) perror("epoll_wait");
+    if (ring) atomic_store(&ring->sleeping, 0);
+    for (int i = 0; i < n; i++) {
+        if (ev[i].data.u64 & EV_PIDFD) reap_pidfd((pid_t)(ev[i].data.u64 & 0x7fffffff));
+        else if (ev[i].data.fd == sfd) drain_signalfd();
+        else if (ev[i].data.fd == bell_fd) {
+            uint64_t v;
+            (void)read(bell_fd, &v, sizeof(v)); // só zera o contador
+        } else if (ev[i].data.fd == arr_fd) {
+            uint64_t v;
+            (void)read(arr_fd, &v, sizeof(v));
+            got_arr = 1;
+        } else if (ev[i].data.fd == ctl_fd) {
+            got_ctl = 1;
+        }
+    }
+}
+
+/* ====== Escalonamento ====== */
+static void dispatch_next(int c)
+{
+    // Escolhe o próximo PRONTO do núcleo e o coloca em RUNNING (SIGCONT). Se fila vazia, loga.
+    cpu_t *cpu = &cpus[c];
+    if (cpu->current != -1) return;
+
+    pcb_t *p;
+    while ((p = rq_pick(c)) != NULL) {
+        pid_t nx = p->pid;
+        if (p->st == ST_FINISHED || !is_alive(nx)) {
+            continue; // pula PIDs mortos/finalizados
+        }
+
+        cpu->current = nx;
+        nswitch++;
+        p->cpu = c;
+        set_state(p, ST_RUNNING);
+        p->run_start_ns = now_ns();
+        p->slice_used = 0;
+        p->slice_target = adaptive ? slice_for(p) : 1;
+        cpu->last_progress_pc = p->last_pc;
+        cpu->progress_cpu_ns = p->host_cpu_ns;
+        cpu->stall_ticks = 0;
+
+        // Multi-núcleo: o app passa a executar na CPU real deste núcleo
+        if (ncpus > 1 && !des && p->host_cpu != cpu->host_cpu) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu->host_cpu, &set);
+            if (sched_setaffinity(nx, sizeof(set), &set) == 0) p->host_cpu = cpu->host_cpu;
+        }
+
+        kev(TR_DISPATCH, c, nx, p->last_pc, p->last_syscall, 0, 0);
+
+        // Libera o processo (se estava parado). A partir daqui, ele pode enviar STATUS.
+        proc_cont(nx);
+        return;
+    }
+
+    /* fila vazia */
+    static long last_print = -1;
+    long now = log_secs();
+    if (now != last_print) {
+        last_print = now;
+        kev(TR_IDLE, -1, -1, 0, 0, 0, 0);
+    }
+}
+
+// Despacha em todo núcleo ocioso
+static void dispatch_idle(void)
+{
+    for (int c = 0; c < ncpus; c++)
+        if (cpus[c].current == -1) dispatch_next(c);
+}
+
+static void preempt_current(int c)
+{
+    // Preempção do processo atual do núcleo (SIGSTOP) e retorno à fila de PRONTOS
+    cpu_t *cpu = &cpus[c];
+    if (cpu->current == -1) return;
+    if (is_alive(cpu->current)) proc_stop(cpu->current);
+    pcb_t *p = bypid(cpu->current);
+    if (p && p->st == ST_RUNNING) {
+        charge_running(p);
+        set_state(p, ST_READY);
+        p->npreempt++;
+        npreempt++;
+        rq_push(cpu->current);
+    }
+    cpu->current = -1;
+    cpu->stall_ticks = 0;    // vai recomeçar em outro processo
+    kev(TR_PREEMPT, c, p ? p->pid : -1, 0, 0, 0, 0);
+}
+
+/* Inicia serviço de I/O se o dispositivo está livre */
+static void start_io_if_idle(int dev)
+{
+    // Se Dn está livre, pega um bloqueado da sua fila e inicia serviço
+    // (o IC cronometra service_ns e devolve IRQ1)
+    device_t *d = &devs[dev];
+    if (d->busy) return;
+    int r = disk_pick(d);
+    if (r < 0) return;
+    ioq_remove(&d->q, r);
+    pid_t p = ioreqs[r].pid;
+
+    d->busy = 1;
+    d->serving = r;
+    d->started_ns = now_ns();
+    d->req_id = next_req_id++;
+    d->nbatch = 0;
+
+    // --io-ms vale para um pedido padrão (WL_IO_UNIT); maiores demoram mais
+    int size = ioreqs[r].size > 0 ? ioreqs[r].size : WL_IO_UNIT;
+    long long svc, addr = -1;
+    if (disk_sched == DS_NONE) {
+        svc = (long long)((double)d->service_ns * size / WL_IO_UNIT);
+        d->bytes += size;
+    } else {
+        long long lo = ioreqs[r].addr, hi = ioreqs[r].addr + size;
+        disk_merge(d, r, &lo, &hi);
+        svc = disk_service(d, lo, hi);
+        d->bytes += hi - lo;
+        addr = lo;
+    }
+
+    if (des) {
+        /* --des: a conclusão vira evento no instante de término */
+        des_ev_t e = {.t = vnow + svc, .type = EV_IO_DONE, .pid = p};
+        e.cqe = (cqe_t){.req_id = d->req_id, .pid = p, .dev = dev,
+                        .t_start_ns = d->started_ns, .t_done_ns = e.t};
+        des_post(&e);
+    } else {
+        /* avisa o InterController: começa cronômetro deste dispositivo */
+        icmsg_t m = {.msg_type = MSG_IO_START, .dev = dev, .pid = p, .service_ns = svc,
+                     .req_id = d->req_id, .t_start_ns = d->started_ns};
+        (void)write(fd_ic_w, &m, sizeof(m));
+    }
+
+    kev(TR_IO_START, -1, p, dev, d->nbatch, addr, svc);
+}
+
+// Publica a contagem de concluídos do processo para o poll do app
+static void aio_publish(pcb_t *p)
+{
+    if (des) des_apps[p->app].aio_done = p->aio_done;
+    else if (kaio && p->slot >= 0) kaio_publish(&kaio[p->slot], (uint32_t)p->aio_done);
+}
+
+// Libera o processo bloqueado em MSG_AIO_WAIT (bloqueado sem SYSCALL
+// pendente) se já alcançou o alvo
+static void aio_wake(pcb_t *p)
+{
+    if (p->st != ST_BLOCKED || p->io_dev >= 0 || p->aio_done < p->aio_target) return;
+    set_state(p, ST_READY);
+    rq_wake(p);
+    kev(TR_AIO_WAKE, -1, p->pid, p->aio_done, p->aio_inflight, 0, 0);
+}
+
+// Conclui o pedido r e o devolve à lista de livres, guardando a latência
+// (submissão -> fim do serviço). SYSCALL: libera o processo; assíncrono:
+// conta a conclusão e libera o processo se ele espera por ela
+static void io_release(device_t *d, int r, const cqe_t *e)
+{
+    if (r < 0) return;
+    ioreq_t q = ioreqs[r];
+    ioreq_put(r);
+    pcb_t *p = q.pid != -1 ? bypid(q.pid) : NULL;
+    if (!p || (!q.async && p->st != ST_BLOCKED)) return;
+    long long now = now_ns();
+    if (d->nlat == d->lat_cap) {
+        d->lat_cap = d->lat_cap ? 2 * d->lat_cap : 256;
+        d->lat = realloc(d->lat, (size_t)d->lat_cap * sizeof(double));
+        if (!d->lat) { perror("disk"); exit(1); }
+    }
+    d->lat[d->nlat++] = (e->t_done_ns - q.submit_ns) / 1e9;
+    if (q.async) {
+        p->aio_inflight--;
+        p->aio_done++;
+        aio_publish(p);
+        kev(TR_AIO_DONE, -1, p->pid, (int)((now - e->t_done_ns) / 1000), p->aio_inflight,
+            e->t_start_ns - q.submit_ns, e->t_done_ns - e->t_start_ns);
+        aio_wake(p);
+        return;
+    }
+    set_state(p, ST_READY);
+    p->io_dev = -1;
+    rq_wake(p);
+    kev(TR_IO_DONE, -1, p->pid, (int)((now - e->t_done_ns) / 1000), 0,
+        e->t_start_ns - q.submit_ns, e->t_done_ns - e->t_start_ns);
+}
+
+// Conclui o pedido descrito por uma entrada da fila de conclusões:
+// libera o processo atendido e reporta a latência ponta a ponta
+// (fila no dispositivo + serviço + entrega da conclusão ao kernel)
+static void io_complete(const cqe_t *e)
+{
+    if (e->dev < 0 || e->dev >= ndevs) return;
+    device_t *d = &devs[e->dev];
+    kev(TR_IRQ1, -1, -1, e->dev, (int)e->req_id, 0, 0);
+
+    if (!d->busy || d->req_id != e->req_id) {
+        // conclusão de um pedido que já não está em serviço (app finalizou)
+        kev(TR_IRQ1_STALE, -1, -1, e->dev, (int)e->req_id, 0, 0);
+        return;
+    }
+
+    d->busy = 0;
+    d->busy_ns += now_ns() - d->started_ns;
+    d->nreq += 1 + d->nbatch;
+    d->nmerged += d->nbatch;
+    io_release(d, d->serving, e);
+    d->serving = -1;
+    for (int i = 0; i < d->nbatch; i++) io_release(d, d->batch[i], e);
+    d->nbatch = 0;
+    start_io_if_idle(e->dev);
+}
+
+// Drena a fila de conclusões em lotes; retorna quantas foram tratadas
+static int drain_completions(void)
+{
+    cqe_t batch[32];
+    int total = 0, n;
+    while ((n = cq_pop_batch(cq, batch, 32)) > 0) {
+        for (int i = 0; i < n; i++) io_complete(&batch[i]);
+        total += n;
+    }
+    return total;
+}
+
+/* ====== Comunicação com apps ====== */
+// O processo p, que se parou sozinho (SYSCALL ou AIO_WAIT), sai da CPU
+static void block_self(pcb_t *p)
+{
+    if (p->st == ST_RUNNING) {
+        proc_stop(p->pid);
+        charge_running(p);
+        sched->block(&cpus[p->cpu].rq, p);
+        set_state(p, ST_BLOCKED);
+        if (cpus[p->cpu].current == p->pid) cpus[p->cpu].current = -1;
+        kev(TR_BLOCK, p->cpu, p->pid, p->last_pc, p->last_syscall, 0, 0);
+    } else {
+        // pedido drenado depois de um PREEMPT (ainda PRONTO, na fila): sai
+        // da fila, senão seria despachado com o I/O pendente
+        if (p->on_rq) {
+            rq_remove(p);
+            sched->block(&cpus[p->cpu].rq, p);
+        }
+        set_state(p, ST_BLOCKED);
+    }
+    burst_end(p);
+}
+
+// Trata uma mensagem de app, venha do pipe ou do anel
+//  - STATUS: atualiza last_pc
+//  - SYSCALL: marca BLOCKED, enfileira em I/O e (se idle) dispara IO-START
+//  - AIO_SUBMIT: enfileira em I/O; o app segue rodando
+//  - AIO_WAIT: marca BLOCKED até o alvo de concluídos; se já chegou, o
+//    app com contador e sem portão (que não se parou) segue rodando
+static void handle_app_msg(const appmsg_t *mp)
+{
+    appmsg_t m = *mp;
+    pcb_t *p = bypid(m.pid);
+    if (!p) return;
+
+    if (m.msg_type == MSG_SYSCALL_RW) {
+        // App pediu I/O: salva o tipo (R/W) no PCB para logs/restauração
+        p->last_syscall = (m.arg ? 1 : 0);
+        kev(TR_SYSCALL, -1, m.pid, m.arg ? 1 : 0, 0, 0, 0);
+        block_self(p);
+        p->nio++;
+        int dev = pick_device(m.dev);
+        io_submit(p, &m, dev);
+        start_io_if_idle(dev);
+    }
+    else if (m.msg_type == MSG_AIO_SUBMIT) {
+        p->last_syscall = (m.arg ? 1 : 0);
+        p->nio++;
+        p->aio_inflight++;
+        kev(TR_AIO_SUBMIT, p->cpu, m.pid, p->last_syscall, p->aio_inflight, 0, 0);
+        int dev = pick_device(m.dev);
+        io_submit(p, &m, dev);
+        start_io_if_idle(dev);
+    }
+    else if (m.msg_type == MSG_AIO_WAIT) {
+        kev(TR_AIO_WAIT, p->cpu, m.pid, m.arg, p->aio_done, 0, 0);
+        if (!des && !park && kaio && p->slot >= 0 && p->aio_done >= m.arg) return;
+        block_self(p);
+        p->aio_target = m.arg;
+        aio_wake(p);   // a conclusão chegou entre o poll do app e o pedido
+    }
+    else if (m.msg_type == MSG_APP_STATUS) {
+        // STATUS: último PC do app (usado no restore e para detectar stall)
+        p->last_pc = m.arg;   // mantém PC atualizado no contexto
+        if (p->cpu >= 0 && cpus[p->cpu].current == p->pid) {
+            /* progresso do processo corrente: zera stall */
+            cpus[p->cpu].last_progress_pc = p->last_pc;
+            cpus[p->cpu].stall_ticks = 0;
+        }
+        kev(TR_PC, p->cpu, p->pid, p->last_pc, 0, 0, 0);
+    }
+}
+
+// Drena mensagens enviadas pelos apps pelo transporte ativo
+static void handle_app_pipe()
+{
+    appmsg_t m;
+    if (ring) {
+        while (msgring_pop(ring, &m)) handle_app_msg(&m);
+        return;
+    }
+    for (;;) {
+        ssize_t r = read(fd_app_r, &m, sizeof(m));
+        if (r < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            perror("read app pipe");
+            break;
+        }
+        if (r == 0) break;
+        if (r != (ssize_t)sizeof(m)) continue;
+        handle_app_msg(&m);
+    }
+}
+
+/* ====== Reaper ====== */
+static void proc_finished(pid_t pid);
+
+// Passa a acompanhar o término de pid por um pidfd na espera; -1 sem
+static int track_exit(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    if (!use_pidfd) return -1;
+    int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (fd < 0) return -1;   // já nasce CLOEXEC
+    struct epoll_event ev = {.events = EPOLLIN, .data.u64 = EV_PIDFD | (uint64_t)pid};
+    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    return fd;
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+// pidfd legível: colhe só esse filho e fecha o pidfd (sai do epoll)
+static void reap_pidfd(pid_t pid)
+{
+    pcb_t *p = bypid(pid);
+    int fd = p ? p->pidfd : -1;
+    for (int j = 0; !p && j < pool_n; j++)
+        if (pool[j].pid == pid) fd = pool[j].pidfd;
+    if (fd < 0) return;
+    // waitid da glibc não devolve o rusage: syscall direta
+    siginfo_t si = {0};
+    struct rusage ru;
+    if (syscall(SYS_waitid, P_PIDFD, fd, &si, WEXITED | WNOHANG, &ru) < 0 || si.si_pid == 0) return;
+    if (!p) {
+        pool_forget(pid);
+        return;
+    }
+    cpu_final(p, &ru);
+    close(fd);
+    p->pidfd = -1;
+    proc_finished(pid);
+}
+// Processo terminou: marca FINISHED e remove de filas
+static void proc_finished(pid_t pid)
+{
+    pcb_t *p = bypid(pid);
+    if (p && p->st != ST_FINISHED) {
+        if (p->cpu >= 0 && cpus[p->cpu].current == pid) {
+            charge_running(p);
+            cpus[p->cpu].current = -1;
+        }
+        set_state(p, ST_FINISHED);
+        finished_count++;
+        if (p->cpu >= 0) sched->exit(&cpus[p->cpu].rq, p);
+
+        /* remova de todas as filas para não despachar de novo */
+        queues_remove_pid(pid);
+        if (p->slot >= 0) slot_free[nslot_free++] = p->slot;
+
+        kev(TR_FINISHED, -1, pid, 0, 0, 0, 0);
+    }
+}
+
+// trata término de filhos
+// (chamado só do loop principal, nunca em contexto de sinal)
+static void on_child_exit()
+{
+    int status;
+    pid_t pid;
+    struct rusage ru;
+    while ((pid = wait4(-1, &status, WNOHANG, &ru)) > 0) {
+        pcb_t *p = bypid(pid);
+        if (p) cpu_final(p, &ru);
+        else pool_forget(pid);
+        proc_finished(pid);
+    }
+}
+
+/* ====== Critério de parada ====== */
+// todos finalizaram e não há nada em filas/serviço
+static int all_done(void)
+{
+    for (int c = 0; c < ncpus; c++)
+        if (cpus[c].current != -1) return 0;
+    return (finished_count == nprocs) && (arr_next == napps_total) && !ctl_open
+           && (ready_total() == 0) && (io_pending() == 0);
+}
+
+/* ====== IRQ0 por núcleo ====== */
+// Tick da grade no instante t (o atual, fora do --tickless)
+static void tick_cpu(int c, long long t)
+{
+    cpu_t *cpu = &cpus[c];
+    pcb_t *cur = (cpu->current != -1) ? bypid(cpu->current) : NULL;
+    if (cur) {
+        charge_until(cur, t);
+        cur->slice_used++;
+    }
+
+    if (cur && !sched->tick(&cpu->rq, cur) && cpu->rq.count > 0) {
+        /* A política mantém o atual mesmo com outros prontos. Cobrada pela
+           CPU medida (--work spin|mem), um app parado por corrida no SIGSTOP
+           não acumula nada e seria mantido para sempre: reforça o CONT */
+        kev(TR_IRQ0_KEEP, c, cur->pid, 0, 0, 0, 0);
+        if (!park && work_mode != WORK_SLEEP) proc_cont(cpu->current);
+    } else if (cur && cpu->rq.count == 0) {
+        /* Único pronto: não preempta — MAS reforça CONT e vigia stall
+           (no --tickless este tick não foi interrupção: sem log nem CONT) */
+        if (!tickless) kev(TR_IRQ0_ONLY, c, cur->pid, 0, 0, 0, 0);
+
+        /* 1) Reforço: se ficou parado em SIGSTOP por corrida, acorda
+              (portões não perdem o CONT: dispensa) */
+        if (!park && !tickless) proc_cont(cpu->current);
+
+        /* 2) Watchdog: se não há progresso de PC (nem de CPU medida, com
+              --work spin|mem: o PC pode levar mais que work_ns), conta stall */
+        if (cur->last_pc == cpu->last_progress_pc && cur->host_cpu_ns == cpu->progress_cpu_ns) {
+            cpu->stall_ticks++;
+        } else {
+            cpu->last_progress_pc = cur->last_pc;
+            cpu->progress_cpu_ns = cur->host_cpu_ns;
+            cpu->stall_ticks = 0;
+        }
+
+        /* 3) Se 5 ticks (e 5 PCs) sem progresso, “nudge”: STOP -> fila -> DISPATCH */
+        if (cpu->stall_ticks >= stall_limit) {
+            kev(TR_NUDGE, c, cur->pid, cpu->stall_ticks, 0, 0, 0);
+            if (is_alive(cpu->current)) proc_stop(cpu->current);
+            set_state(cur, ST_READY);
+            cur->npreempt++;
+            npreempt++;
+            rq_push(cpu->current);
+            cpu->current = -1;
+            cpu->stall_ticks = 0;
+            dispatch_next(c);
+        }
+    } else {
+        /* Há 2+ prontos: preempta normalmente */
+        if (cur || !tickless) kev(TR_IRQ0, c, cur ? cur->pid : -1, 0, 0, 0, 0);
+        preempt_current(c);
+        dispatch_next(c);
+    }
+}
+
+/* ====== Tickless ====== */
+// Modo de timer que o estado atual dos núcleos pede
+static int tick_want(void)
+{
+    int mode = TK_OFF;
+    for (int c = 0; c < ncpus; c++) {
+        if (cpus[c].current == -1) continue;
+        if (cpus[c].rq.count > 0) return TK_HZ;
+        mode = TK_WATCH;
+    }
+    return mode;
+}
+
+// Trata os ticks da grade vencidos até `now`, com o estado dos núcleos de
+// enquanto o kernel dormia (chamado antes de tratar os eventos da rodada).
+// Com todos os núcleos ociosos (e portanto filas vazias) o tick não faz
+// nada: a grade pula direto para depois de now.
+static void tick_catch_up(long long now)
+{
+    while (tick_next <= now) {
+        int mode = tick_want();
+        if (mode == TK_OFF) {
+            long long k = (now - tick_next) / quantum_ns + 1;
+            tick_skipped += k;
+            tick_next += k * quantum_ns;
+            break;
+        }
+        if (mode != TK_HZ) tick_replayed++;
+        else if (des) tick_irqs++;
+        for (int c = 0; c < ncpus; c++) tick_cpu(c, tick_next);
+        tick_next += quantum_ns;
+    }
+}
+
+// Programa o timer do IC para o modo pedido, só quando o modo muda: em
+// TK_HZ no próximo tick da grade; em TK_WATCH no primeiro tick em que o
+// vigia pode disparar; em TK_OFF desarma
+static void tick_program(void)
+{
+    int mode = tick_want();
+    if (mode == tick_mode) return;
+    tick_mode = mode;
+    icmsg_t m = {.msg_type = MSG_TICK};
+    if (mode == TK_HZ) {
+        m.t_start_ns = tick_next;
+        m.service_ns = quantum_ns;
+    } else if (mode == TK_WATCH) {
+        m.t_start_ns = tick_next + (stall_limit - 1) * quantum_ns;
+        m.service_ns = stall_limit * quantum_ns;
+    }
+    (void)write(fd_ic_w, &m, sizeof(m));
+}
+
+// Custo do próprio loop: quanto de um núcleo real o kernel usou
+static void report_loop_cost(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    double cpu_s = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec
+                   + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+    double wall_s = (real_ns() - boot_ns) / 1e9;
+    log_ts_prefix();
+    if (des)
+        printf(C_SCH "LOOP      ~~ DES: %ld eventos, %.1f s virtuais em %.1f ms reais, %ld trocas de contexto" C_RST "\n",
+               des_events, vnow / 1e9, wall_s * 1e3, nswitch);
+    else
+        printf(C_SCH "LOOP      ~~ kernel: %.1f ms de CPU em %.1f s (%.2f%% de um núcleo), %ld rodadas, %ld trocas de contexto" C_RST "\n",
+               cpu_s * 1e3, wall_s, wall_s > 0 ? 100.0 * cpu_s / wall_s : 0.0, loop_rounds, nswitch);
+    log_ts_prefix();
+    printf(C_SCH "LOOP      ~~ timer%s: %ld IRQ0, %ld ticks repostos sem interrupção, %ld com todos ociosos" C_RST "\n",
+           tickless ? " (tickless)" : "", tick_irqs, tick_replayed, tick_skipped);
+    if (coro) {
+        log_ts_prefix();
+        printf(C_SCH "LOOP      ~~ corrotinas: %ld retomadas, %.0f ns cada (ida e volta)" C_RST "\n",
+               coro_resumes, coro_resumes ? (double)coro_ns / coro_resumes : 0.0);
+    }
+    if (des || spawn_count == 0) return;
+    log_ts_prefix();
+    printf(C_SCH "SPAWN     ~~ %ld apps (%s): %.1f us por app no loop (máx %.1f us, %.0f apps/s),"
+           " rodada de admissão máx %.2f ms" C_RST "\n",
+           spawn_count, spawn_names[spawn_mode], spawn_ns / 1e3 / spawn_count, spawn_max_ns / 1e3,
+           spawn_ns > 0 ? spawn_count / (spawn_ns / 1e9) : 0.0, admit_max_ns / 1e6);
+    if (spawn_mode == SP_POOL) {
+        log_ts_prefix();
+        printf(C_SCH "SPAWN     ~~ reserva de %d zigotos: %ld chegadas sem zigoto livre (criadas direto)" C_RST "\n",
+               pool_target, pool_miss);
+    }
+}
+
+/* ====== Métricas e relatório ====== */
+typedef struct { double mean, p50, p90, p99, max; } dstat_t;
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Média e percentis (posto mais próximo) de v[0..n-1]; ordena v
+static dstat_t dstat(double *v, int n)
+{
+    dstat_t r = {0};
+    if (n == 0) return r;
+    qsort(v, (size_t)n, sizeof(double), cmp_double);
+    for (int i = 0; i < n; i++) r.mean += v[i];
+    r.mean /= n;
+    r.p50 = v[(n * 50 + 99) / 100 - 1];
+    r.p90 = v[(n * 90 + 99) / 100 - 1];
+    r.p99 = v[(n * 99 + 99) / 100 - 1];
+    r.max = v[n - 1];
+    return r;
+}
+
+static void json_stat(FILE *f, const char *key, dstat_t s, const char *sep)
+{
+    fprintf(f, "    \"%s\": {\"mean\": %.6f, \"p50\": %.6f, \"p90\": %.6f, \"p99\": %.6f, \"max\": %.6f}%s\n",
+            key, s.mean, s.p50, s.p90, s.p99, s.max, sep);
+}
+
+// Resumo no log e, se pedido, relatório JSON/CSV com as métricas de
+// cada processo, dos núcleos e dos dispositivos. Tempos em segundos
+// desde o boot, no relógio do kernel (virtual no --des).
+static void write_report(void)
+{
+    long long base = des ? 0 : boot_ns;
+    double span = (end_ns - base) / 1e9;
+    int n = pt.n;
+    double *ta = calloc((size_t)n + 1, sizeof(double));
+    double *wt = calloc((size_t)n + 1, sizeof(double));
+    double *rt = calloc((size_t)n + 1, sizeof(double));
+    if (!ta || !wt || !rt) { perror("report"); free(ta); free(wt); free(rt); return; }
+    for (int i = 0; i < n; i++) {
+        pcb_t *p = &pt.v[i];
+        ta[i] = (p->t_finish - p->t_arrival) / 1e9;
+        wt[i] = p->wait_ns / 1e9;
+        rt[i] = p->t_first_run >= 0 ? (p->t_first_run - p->t_arrival) / 1e9 : 0;
+    }
+    dstat_t s_ta = dstat(ta, n), s_wt = dstat(wt, n), s_rt = dstat(rt, n);
+    long long busy = 0;
+    for (int c = 0; c < ncpus; c++) busy += cpus[c].busy_ns;
+    double util = span > 0 ? busy / 1e9 / (span * ncpus) : 0;
+
+    // CPU de verdade (modo real): a dos apps medida no host contra a
+    // assumida (tempo em RUNNING); o overhead é a parte do kernel e do IC
+    // na CPU toda. Justiça: índice de Jain da fração do tempo em que cada
+    // processo queria CPU (RUNNING + READY) que ele teve de fato (sem pesos)
+    double app_cpu = 0, ran = 0, k_cpu = 0, ic_cpu = 0, overhead = 0, jain_m = 0, jain_a = 0;
+    if (!des) {
+        double sm = 0, sm2 = 0, sa = 0, sa2 = 0;
+        int nj = 0;
+        for (int i = 0; i < n; i++) {
+            pcb_t *p = &pt.v[i];
+            app_cpu += p->host_cpu_ns / 1e9;
+            ran += p->cpu_ns / 1e9;
+            if (p->cpu_ns + p->wait_ns <= 0) continue;
+            double xm = (double)p->host_cpu_ns / (p->cpu_ns + p->wait_ns);
+            double xa = (double)p->cpu_ns / (p->cpu_ns + p->wait_ns);
+            sm += xm, sm2 += xm * xm, sa += xa, sa2 += xa * xa, nj++;
+        }
+        jain_m = sm2 > 0 ? sm * sm / (nj * sm2) : 0;
+        jain_a = sa2 > 0 ? sa * sa / (nj * sa2) : 0;
+        k_cpu = (clock_ns(CLOCK_PROCESS_CPUTIME_ID) - kcpu_boot_ns) / 1e9;
+        clockid_t icc;
+        if (ic_pid > 0 && clock_getcpuclockid(ic_pid, &icc) == 0) ic_cpu = clock_ns(icc) / 1e9;
+        if (ic_cpu < 0) ic_cpu = 0;
+        overhead = k_cpu + ic_cpu + app_cpu > 0 ? (k_cpu + ic_cpu) / (k_cpu + ic_cpu + app_cpu) : 0;
+    }
+
+    log_ts_prefix();
+    printf(C_SCH "METRICAS  ~~ turnaround p50=%.2fs p99=%.2fs | espera p50=%.2fs p99=%.2fs |"
+           " resposta p50=%.2fs p99=%.2fs | CPU %.1f%%, %ld trocas" C_RST "\n",
+           s_ta.p50, s_ta.p99, s_wt.p50, s_wt.p99, s_rt.p50, s_rt.p99, 100 * util, nswitch);
+    if (!des) {
+        log_ts_prefix();
+        printf(C_SCH "CPU-HOST  ~~ apps %.3fs medidos (%.3fs em RUNNING) | kernel %.3fs + IC %.3fs:"
+               " overhead %.1f%% | justiça (Jain) medida %.3f, assumida %.3f" C_RST "\n",
+               app_cpu, ran, k_cpu, ic_cpu, 100 * overhead, jain_m, jain_a);
+    }
+
+    // I/O: latência por dispositivo e de todos os pedidos juntos
+    int nlat = 0;
+    long long io_bytes = 0;
+    for (int d = 0; d < ndevs; d++) nlat += devs[d].nlat, io_bytes += devs[d].bytes;
+    double *lat = calloc((size_t)nlat + 1, sizeof(double));
+    dstat_t *s_dev = calloc((size_t)ndevs + 1, sizeof(dstat_t));
+    if (!lat || !s_dev) { perror("report"); exit(1); }
+    nlat = 0;
+    for (int d = 0; d < ndevs; d++) {
+        memcpy(lat + nlat, devs[d].lat, (size_t)devs[d].nlat * sizeof(double));
+        nlat += devs[d].nlat;
+        s_dev[d] = dstat(devs[d].lat, devs[d].nlat);
+    }
+    dstat_t s_io = dstat(lat, nlat);
+    double io_mb_s = span > 0 ? io_bytes / 1048576.0 / span : 0;
+    long naio = 0;
+    for (int i = 0; i < n; i++) naio += pt.v[i].aio_done;
+    if (naio > 0) {
+        log_ts_prefix();
+        printf(C_IO "AIO       ~~ %ld de %d pedidos assíncronos (kaio.h); %.2f apps/s, %.2f MB/s" C_RST "\n",
+               naio, nlat, span > 0 ? n / span : 0, io_mb_s);
+    }
+    for (int d = 0; d < ndevs && disk_sched != DS_NONE; d++) {
+        log_ts_prefix();
+        printf(C_IO "DISCO     ~~ D%d (%s): %d pedidos, %d juntados, %.2f MB/s, seek %.2fs de %.2fs,"
+               " latência p50=%.3fs p99=%.3fs" C_RST "\n",
+               d + 1, disk_names[disk_sched], devs[d].nreq, devs[d].nmerged,
+               span > 0 ? devs[d].bytes / 1048576.0 / span : 0, devs[d].seek_ns / 1e9,
+               devs[d].busy_ns / 1e9, s_dev[d].p50, s_dev[d].p99);
+    }
+
+    FILE *f;
+    if (report_csv && (f = fopen(report_csv, "w")) != NULL) {
+        fprintf(f, "name,pid,weight,arrival_s,first_run_s,finish_s,turnaround_s,response_s,"
+                   "cpu_s,wait_s,blocked_s,dispatches,preemptions,io,cpu_host_s\n");
+        for (int i = 0; i < n; i++) {
+            pcb_t *p = &pt.v[i];
+            fprintf(f, "%s,%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%d,%d,%d,%.6f\n",
+                    p->name, (int)p->pid, p->weight,
+                    (p->t_arrival - base) / 1e9,
+                    p->t_first_run >= 0 ? (p->t_first_run - base) / 1e9 : -1.0,
+                    (p->t_finish - base) / 1e9,
+                    (p->t_finish - p->t_arrival) / 1e9,
+                    p->t_first_run >= 0 ? (p->t_first_run - p->t_arrival) / 1e9 : -1.0,
+                    p->cpu_ns / 1e9, p->wait_ns / 1e9, p->blocked_ns / 1e9,
+                    p->ndispatch, p->npreempt, p->nio, des ? -1.0 : p->host_cpu_ns / 1e9);
+        }
+        fclose(f);
+    } else if (report_csv) perror(report_csv);
+
+    if (report_json && (f = fopen(report_json, "w")) != NULL) {
+        fprintf(f, "{\n  \"config\": {\"policy\": \"%s\", \"apps\": %d, \"cpus\": %d, \"devices\": %d,"
+                   " \"quantum_ms\": %.6f, \"work_ms\": %.6f, \"time_scale\": %g, \"des\": %s,"
+                   " \"disk_sched\": \"%s\", \"adaptive\": %s},\n",
+                sched->name, n, ncpus, ndevs, quantum_ns / 1e6, work_ns / 1e6, time_scale,
+                des ? "true" : "false", disk_names[disk_sched], adaptive ? "true" : "false");
+        fprintf(f, "  \"summary\": {\n    \"span_s\": %.6f,\n    \"cpu_util\": %.6f,\n"
+                   "    \"idle_s\": %.6f,\n    \"context_switches\": %ld,\n    \"preemptions\": %ld,\n"
+                   "    \"io_lat_p50_s\": %.6f,\n    \"io_lat_p99_s\": %.6f,\n    \"io_mb_s\": %.6f,\n"
+                   "    \"aio_requests\": %ld,\n    \"apps_per_s\": %.6f,\n",
+                span, util, span * ncpus - busy / 1e9, nswitch, npreempt, s_io.p50, s_io.p99, io_mb_s,
+                naio, span > 0 ? n / span : 0);
+        json_stat(f, "turnaround_s", s_ta, ",");
+        json_stat(f, "waiting_s", s_wt, ",");
+        json_stat(f, "response_s", s_rt, "");
+        fprintf(f, "  },\n");
+        if (!des)
+            fprintf(f, "  \"spawn\": {\"mode\": \"%s\", \"count\": %ld, \"mean_us\": %.3f, \"max_us\": %.3f,"
+                       " \"per_s\": %.1f, \"admit_round_max_ms\": %.3f, \"pool_miss\": %ld},\n",
+                    spawn_names[spawn_mode], spawn_count,
+                    spawn_count ? spawn_ns / 1e3 / spawn_count : 0.0, spawn_max_ns / 1e3,
+                    spawn_ns > 0 ? spawn_count / (spawn_ns / 1e9) : 0.0, admit_max_ns / 1e6, pool_miss);
+        if (!des)
+            fprintf(f, "  \"host\": {\"work\": \"%s\", \"iters_per_pc\": %lld, \"apps_cpu_s\": %.6f,"
+                       " \"running_s\": %.6f, \"kernel_cpu_s\": %.6f, \"ic_cpu_s\": %.6f, \"sched_overhead\": %.6f,"
+                       " \"fairness_measured\": %.6f, \"fairness_assumed\": %.6f},\n",
+                    work_names[work_mode], work_iters, app_cpu, ran, k_cpu, ic_cpu, overhead, jain_m, jain_a);
+        fprintf(f, "  \"cpus\": [\n");
+        for (int c = 0; c < ncpus; c++)
+            fprintf(f, "    {\"cpu\": %d, \"busy_s\": %.6f, \"util\": %.6f}%s\n", c + 1,
+                    cpus[c].busy_ns / 1e9, span > 0 ? cpus[c].busy_ns / 1e9 / span : 0,
+                    c + 1 < ncpus ? "," : "");
+        fprintf(f, "  ],\n  \"devices\": [\n");
+        for (int d = 0; d < ndevs; d++)
+            fprintf(f, "    {\"dev\": %d, \"requests\": %d, \"bytes\": %lld, \"busy_s\": %.6f, \"util\": %.6f,"
+                       " \"merged\": %d, \"seek_s\": %.6f, \"mb_s\": %.6f, \"lat_p50_s\": %.6f, \"lat_p99_s\": %.6f}%s\n",
+                    d + 1, devs[d].nreq, devs[d].bytes, devs[d].busy_ns / 1e9, span > 0 ? devs[d].busy_ns / 1e9 / span : 0,
+                    devs[d].nmerged, devs[d].seek_ns / 1e9, span > 0 ? devs[d].bytes / 1048576.0 / span : 0,
+                    s_dev[d].p50, s_dev[d].p99, d + 1 < ndevs ? "," : "");
+        fprintf(f, "  ],\n  \"processes\": [\n");
+        for (int i = 0; i < n; i++) {
+            pcb_t *p = &pt.v[i];
+            fprintf(f, "    {\"name\": \"%s\", \"pid\": %d, \"weight\": %d, \"arrival_s\": %.6f,"
+                       " \"first_run_s\": %.6f, \"finish_s\": %.6f, \"turnaround_s\": %.6f,"
+                       " \"response_s\": %.6f, \"cpu_s\": %.6f, \"wait_s\": %.6f, \"blocked_s\": %.6f,"
+                       " \"dispatches\": %d, \"preemptions\": %d, \"io\": %d, \"aio\": %d, \"burst_est_s\": %.6f,"
+                       " \"cpu_host_s\": %.6f}%s\n",
+                    p->name, (int)p->pid, p->weight,
+                    (p->t_arrival - base) / 1e9,
+                    p->t_first_run >= 0 ? (p->t_first_run - base) / 1e9 : -1.0,
+                    (p->t_finish - base) / 1e9,
+                    (p->t_finish - p->t_arrival) / 1e9,
+                    p->t_first_run >= 0 ? (p->t_first_run - p->t_arrival) / 1e9 : -1.0,
+                    p->cpu_ns / 1e9, p->wait_ns / 1e9, p->blocked_ns / 1e9,
+                    p->ndispatch, p->npreempt, p->nio, p->aio_done, p->burst_est / 1e9,
+                    des ? -1.0 : p->host_cpu_ns / 1e9, i + 1 < n ? "," : "");
+        }
+        fprintf(f, "  ]\n}\n");
+        fclose(f);
+    } else if (report_json) perror(report_json);
+
+    free(ta);
+    free(wt);
+    free(rt);
+    free(lat);
+    free(s_dev);
+}
+
+/* ====== Retrato ao vivo (--stats) ====== */
+// Os tempos incluem o trecho em andamento (estado atual, serviço atual)
+static void stats_row(ks_proc_t *r, const pcb_t *p, long long now)
+{
+    long long dt = now - p->t_state;
+    r->pid = p->pid;
+    memcpy(r->name, p->name, MAX_NAME);
+    r->st = p->st;
+    r->cpu = p->cpu;
+    r->last_pc = p->last_pc;
+    r->io_dev = p->io_dev;
+    r->aio_inflight = p->aio_inflight;
+    r->ndispatch = p->ndispatch;
+    r->npreempt = p->npreempt;
+    r->nio = p->nio;
+    r->cpu_ns = p->cpu_ns + (p->st == ST_RUNNING ? dt : 0);
+    r->wait_ns = p->wait_ns + (p->st == ST_READY ? dt : 0);
+    r->blocked_ns = p->blocked_ns + (p->st == ST_BLOCKED ? dt : 0);
+}
+
+// Reescreve o retrato inteiro sob o seqlock. Se não cabem todos os
+// processos, os finalizados ficam de fora primeiro
+static void stats_publish(int done)
+{
+    kstat_t *k = kst;
+    long long now = now_ns();
+    ks_write_begin(k);
+    k->done = done;
+    k->des = des;
+    snprintf(k->policy, sizeof(k->policy), "%s", sched->name);
+    k->ncpus = ncpus < KS_MAX_CPUS ? ncpus : KS_MAX_CPUS;
+    k->ndevs = ndevs < KS_MAX_DEVS ? ndevs : KS_MAX_DEVS;
+    k->total = pt.n;
+    k->finished = finished_count;
+    k->ready = ready_total();
+    k->io_pending = io_pending();
+    k->now_ns = des ? vnow : real_ns() - boot_ns;
+    k->real_ns = real_ns();
+    k->nswitch = nswitch;
+    k->npreempt = npreempt;
+    k->tick_irqs = tick_irqs;
+    k->loop_rounds = loop_rounds;
+    k->des_events = des_events;
+    k->io_done = 0;
+    for (int c = 0; c < k->ncpus; c++) {
+        pcb_t *p = cpus[c].current >= 0 ? bypid(cpus[c].current) : NULL;
+        k->cpus[c] = (ks_cpu_t){.current = cpus[c].current, .ready = cpus[c].rq.count,
+                                .busy_ns = cpus[c].busy_ns + (p && p->st == ST_RUNNING ? now - p->t_state : 0)};
+    }
+    for (int d = 0; d < ndevs; d++) {
+        k->io_done += devs[d].nreq;
+        if (d < k->ndevs)
+            k->devs[d] = (ks_dev_t){.queued = devs[d].q.count,
+                                    .serving = devs[d].busy && devs[d].serving >= 0 ? ioreqs[devs[d].serving].pid : -1,
+                                    .nreq = devs[d].nreq, .nmerged = devs[d].nmerged, .bytes = devs[d].bytes,
+                                    .busy_ns = devs[d].busy_ns + (devs[d].busy ? now - devs[d].started_ns : 0)};
+    }
+    int n = 0;
+    for (int pass = 0; pass < 2; pass++)
+        for (int i = 0; i < pt.n && n < (int)k->cap; i++)
+            if ((pt.v[i].st == ST_FINISHED) == pass) stats_row(&k->procs[n++], &pt.v[i], now);
+    k->nprocs = n;
+    ks_write_end(k);
+}
+
+// Publica se já passou KS_PERIOD_NS desde a última vez (fim de rodada)
+static void stats_tick(void)
+{
+    long long t = real_ns();
+    if (t - kst_last_ns < KS_PERIOD_NS) return;
+    kst_last_ns = t;
+    stats_publish(0);
+}
+
+/* ====== Loop principal ====== */
+// reage a eventos e mantém a política de escalonamento
+// Ordem de reação:
+//   1) drena pipe de apps
+//   2) IRQ1 (fila de conclusões de I/O) — desbloqueia e redispatch
+//   3) IRQ0 (timer) — preempta se houver disputa; único pronto continua
+//   4) SIGALRM (nudge) — se CPU ociosa, despacha
+//   5) coleta filhos terminados; checa critério de parada
+// Entre uma rodada e outra o kernel dorme em wait_events() até chegar
+// mensagem no pipe ou um dos sinais (não há mais polling de 10ms).
+static void schedule_loop()
+{
+    for (;;) {
+        if (tickless) tick_catch_up(now_ns());
+
+        handle_app_pipe();
+
+        if (got_ctl) {
+            got_ctl = 0;
+            ctl_read();
+        }
+
+        if (got_arr) {
+            got_arr = 0;
+            admit_arrivals();
+        }
+
+        // Fim de I/O: drena a fila de conclusões, libera os processos e
+        // reinicia os dispositivos. IRQ1 pode coalescer; a fila não perde nada.
+        got_irq1 = 0;
+        if (drain_completions() > 0) dispatch_idle();
+
+        // Tick do timer (IRQ0): em cada núcleo, a política decide entre
+        // manter o atual ou preemptar (no --tickless, já no início da rodada)
+        if (got_irq0) {
+            got_irq0 = 0;
+            if (!tickless)
+                for (int c = 0; c < ncpus; c++) tick_cpu(c, now_ns());
+            dispatch_idle();
+        }
+
+        if (got_sysc) {
+            got_sysc = 0;
+            dispatch_idle();
+        }
+
+        if (got_chld) {
+            got_chld = 0;
+            on_child_exit();
+        }
+
+        if (all_done()) {
+            end_ns = now_ns();
+            report_loop_cost();
+            write_report();
+            if (kst) stats_publish(1);
+            log_ts_prefix();
+            printf(C_SCH "TERMINOU: todos os apps finalizaram; encerrando Kernel e IC" C_RST "\n");
+            pool_drain();
+            if (ic_pid > 0) kill(ic_pid, SIGTERM);
+            if (ic_pid > 0) waitpid(ic_pid, NULL, 0);
+            break;
+        }
+
+        dispatch_idle();
+
+        // Reserva de zigotos: completa aos poucos, sem dormir enquanto falta
+        int refill = pool_fill(POOL_BATCH) > 0 && pool_n < pool_target;
+        if (tickless) tick_program();
+        if (kst) stats_tick();
+        wait_events(got_arr || refill);
+        loop_rounds++;
+    }
 }
 
-// Resolve PID -> nome curto (A1..An) para logs
-static const char *name_of(pid_t pid)
+/* ====== Modo de eventos discretos ====== */
+// Ordem dos eventos: instante; no mesmo instante o IRQ0 vem antes (no modo
+// real o timer do IC parte antes dos apps, então sua fase está à frente);
+// os demais na ordem em que foram agendados
+static int des_less(const des_ev_t *a, const des_ev_t *b)
 {
-    for (int i = 0; i < nprocs; i++)
-        if (procs[i].pid == pid)
-            return procs[i].name;
-    return "?";
+    if (a->t != b->t) return a->t < b->t;
+    if ((a->type == EV_TICK) != (b->type == EV_TICK)) return a->type == EV_TICK;
+    return a->seq < b->seq;
 }
 
-// Busca o PCB pelo PID; retorna NULL se não encontrado
-static pcb_t *bypid(pid_t pid)
+static void des_post(const des_ev_t *e)
 {
-    for (int i = 0; i < nprocs; i++)
-        if (procs[i].pid == pid)
-            return &procs[i];
-    return NULL;
+    if (des_n == des_cap) {
+        des_cap = des_cap ? 2 * des_cap : 256;
+        des_q = realloc(des_q, (size_t)des_cap * sizeof(des_ev_t));
+        if (!des_q) { perror("des"); exit(1); }
+    }
+    des_ev_t x = *e;
+    x.seq = ++des_seq;
+    int i = des_n++;
+    while (i > 0) {
+        des_ev_t *up = &des_q[(i - 1) / 2];
+        if (des_less(up, &x)) break;
+        des_q[i] = *up;
+        i = (i - 1) / 2;
+    }
+    des_q[i] = x;
 }
 
-// Coloca um FD em modo não-bloqueante (usado em fd_app_r)
-static void set_nonblock(int fd)
+static int des_pop(des_ev_t *out)
 {
-    int fl = fcntl(fd, F_GETFL, 0);
-    fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+    if (des_n == 0) return 0;
+    *out = des_q[0];
+    des_ev_t last = des_q[--des_n];
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= des_n) break;
+        if (c + 1 < des_n && des_less(&des_q[c + 1], &des_q[c])) c++;
+        if (des_less(&last, &des_q[c])) break;
+        des_q[i] = des_q[c];
+        i = c;
+    }
+    if (des_n > 0) des_q[i] = last;
+    return 1;
 }
 
-/* === Helpers de vida e limpeza de filas === */
-// Checa se o processo ainda existe (kill(pid,0)==0)
-static int is_alive(pid_t pid) {
-    return (kill(pid, 0) == 0);
+// Mensagem do passo k do programa do app simulado a, como em app.c:
+// I/O (SYSCALL ou AIO_SUBMIT), AIO_WAIT (só se o poll não basta; no fim,
+// espera todos) ou STATUS de um novo PC. 0 = nada a enviar neste passo
+static int des_msg(des_app_t *a, int k, const wl_op_t *io, appmsg_t *m)
+{
+    if (k == WL_WAIT || k == WL_END) {
+        int inflight = k == WL_WAIT ? io->n : 0;
+        if (inflight >= a->aio_sub || a->aio_done >= a->aio_sub - inflight) return 0;
+        *m = (appmsg_t){.msg_type = MSG_AIO_WAIT, .arg = a->aio_sub - inflight};
+    } else if (k != WL_CPU) {
+        int async = k == WL_AREAD || k == WL_AWRITE;
+        *m = (appmsg_t){.msg_type = async ? MSG_AIO_SUBMIT : MSG_SYSCALL_RW, .arg = wl_is_write(k),
+                        .dev = io->dev, .size = io->size, .addr = io->addr};
+        a->aio_sub += async;
+    } else {
+        *m = (appmsg_t){.msg_type = MSG_APP_STATUS, .arg = ++a->pc};
+    }
+    return 1;
 }
 
-/* ==== Helpers de fila de PRONTOS (push/pop) — ignoram PIDs finalizados ===*/
-static void rq_push(pid_t p)
+// Próxima mensagem do app simulado p; 0 quando o programa acabou
+static int des_next(pcb_t *p, appmsg_t *m)
 {
-    pcb_t *pp = bypid(p);
-    if (pp && pp->st == ST_FINISHED) return; // não enfileira finalizado
-    if (rq_count >= MAX_APPS) return;
-    rq[rq_tail] = p;
-    rq_tail = (rq_tail + 1) % MAX_APPS;
-    rq_count++;
-}
-static int rq_pop(pid_t *p)
-{
-    if (rq_count == 0) return 0;
-    *p = rq[rq_head];
-    rq_head = (rq_head + 1) % MAX_APPS;
-    rq_count--;
+    des_app_t *a = &des_apps[p->app];
+    wl_op_t io;
+    for (;;) {
+        int k = wl_next(&wload[p->app], &a->cur, &io);
+        if (des_msg(a, k, &io, m)) break;
+        if (k == WL_END) return 0;
+    }
+    m->pid = p->pid;
     return 1;
 }
 
-/* === Helpers de fila de I/O (push/pop) — ordem de chegada (FIFO) === */
-static void io_push(pid_t p)
+// Corrotina: entrega uma mensagem ao kernel e para até ser retomada
+static void coro_send(coro_app_t *c, appmsg_t m)
 {
-    if (io_count >= MAX_APPS) return;
-    io_q[io_tail] = p;
-    io_tail = (io_tail + 1) % MAX_APPS;
-    io_count++;
+    c->msg = m;
+    task_yield(&c->t);
 }
-static int io_pop(pid_t *p)
+
+// aio_wait de app.c na corrotina: o poll lê o contador do app simulado
+static void coro_wait(coro_app_t *c, int sub, int inflight)
 {
-    if (io_count == 0) return 0;
-    *p = io_q[io_head];
-    io_head = (io_head + 1) % MAX_APPS;
-    io_count--;
-    return 1;
+    if (inflight >= sub || des_apps[c->app].aio_done >= sub - inflight) return;
+    coro_send(c, (appmsg_t){.msg_type = MSG_AIO_WAIT, .arg = sub - inflight});
 }
 
-/* limpeza de filas */
-// Remove um PID de dentro da fila — usado ao FINISH
-static void rq_remove_pid(pid_t pid) {
-    int n = rq_count;
-    for (int i = 0; i < n; i++) {
-        pid_t p;
-        if (!rq_pop(&p)) break;
-        if (p != pid) rq_push(p);
+// Corpo de um app no --coro: o laço de app.c, com o envio ao kernel
+// como ponto de parada. Depois de um STATUS, a corrotina só volta quando
+// o PC termina (EV_APP_STEP) com o app em execução; depois de um pedido
+// de I/O ou de um wait, no CONT que segue a conclusão; depois de uma
+// submissão assíncrona, logo em seguida.
+static void coro_main(void)
+{
+    coro_app_t *c = coro_self;
+    const wl_app_t *prog = &wload[c->app];
+    wl_cur_t cur;
+    wl_op_t io;
+    int pc = 0, sub = 0, k;
+    wl_start(&cur, c->app + 1);
+    while ((k = wl_next(prog, &cur, &io)) != WL_END) {
+        if (k == WL_WAIT) {
+            coro_wait(c, sub, io.n);
+            continue;
+        }
+        if (k != WL_CPU) {
+            int async = k == WL_AREAD || k == WL_AWRITE;
+            coro_send(c, (appmsg_t){.msg_type = async ? MSG_AIO_SUBMIT : MSG_SYSCALL_RW,
+                                    .arg = wl_is_write(k), .dev = io.dev, .size = io.size, .addr = io.addr});
+            sub += async;
+            continue;
+        }
+        coro_send(c, (appmsg_t){.msg_type = MSG_APP_STATUS, .arg = ++pc});
     }
+    coro_wait(c, sub, 0);
+    task_exit(&c->t);
 }
-static void io_remove_pid(pid_t pid) {
-    int n = io_count;
-    for (int i = 0; i < n; i++) {
-        pid_t p;
-        if (!io_pop(&p)) break;
-        if (p != pid) io_push(p);
-    }
-    if (io_serving == pid) {
-        io_serving = -1;
-        io_busy = 0;
+
+// Próxima mensagem do app p no --coro: retoma a corrotina até o próximo
+// ponto de parada (a pilha só é preparada na primeira vez); 0 quando acabou
+static int coro_next(pcb_t *p, appmsg_t *m)
+{
+    coro_app_t *c = &coros[p->app];
+    if (!c->t.started) task_init(&c->t, coro_stacks + (size_t)p->app * TASK_STACK, coro_main);
+    coro_self = c;
+    long long t0 = real_ns();
+    task_resume(&c->t);
+    coro_ns += real_ns() - t0;
+    coro_resumes++;
+    if (c->t.done) {
+        task_release(&c->t);
+        return 0;
     }
+    *m = c->msg;
+    m->pid = p->pid;
+    return 1;
 }
 
-/* ====== Sinais ====== */
-static void on_irq0(int s){ (void)s; got_irq0 = 1; }
-static void on_irq1(int s){ (void)s; got_irq1 = 1; }
-static void on_sysc(int s){ (void)s; got_sysc = 1; }
-
-/* ====== Escalonamento ====== */
-static void dispatch_next()
+// O app segue até a próxima mensagem: STATUS (o PC termina em work_ns),
+// pedido de I/O ou wait (fica parado até o CONT) ou fim; submissões
+// assíncronas não param o app
+static void des_advance(pcb_t *p)
 {
-    // Escolhe o próximo PRONTO e o coloca em RUNNING (SIGCONT). Se fila vazia, loga.
-    if (current != -1) return;
-
-    pid_t nx;
-    while (rq_pop(&nx)) {
-        pcb_t *p = bypid(nx);
-        if (!p || p->st == ST_FINISHED || !is_alive(nx)) {
-            continue; // pula PIDs mortos/finalizados
+    des_ev_t e = {.t = vnow, .type = EV_APP_EXIT, .pid = p->pid};
+    appmsg_t m;
+    do {
+        if (!(coro ? coro_next(p, &m) : des_next(p, &m))) {
+            des_post(&e);
+            return;
         }
-
-        current = nx;
-        p->st = ST_RUNNING;
-        last_progress_pc = p->last_pc;
-        stall_ticks = 0;
-
-        log_ts_prefix();
-        printf(C_SCH "DISPATCH  -> %-3s (pid=%d) [restore PC=%d, RW=%s]" C_RST "\n",
-               name_of(nx), (int)nx,
-               p->last_pc,
-               (p->last_syscall != -1) ? (p->last_syscall ? "W" : "R") : "-");
-        
-        // Libera o processo (se estava parado). A partir daqui, ele pode enviar STATUS.
-        kill(nx, SIGCONT);
+        if (m.msg_type == MSG_AIO_SUBMIT) handle_app_msg(&m);
+    } while (m.msg_type == MSG_AIO_SUBMIT);
+    if (m.msg_type == MSG_SYSCALL_RW || m.msg_type == MSG_AIO_WAIT) {
+        des_apps[p->app].need_advance = 1;
+        handle_app_msg(&m);
         return;
     }
-
-    /* fila vazia */
-    static time_t last_print = 0;
-    time_t now = time(NULL);
-    if (now != last_print) {
-        last_print = now;
-        log_ts_prefix();
-        printf(C_SCH "DISPATCH  (fila vazia) — aguardando próximo evento" C_RST "\n");
-    }
+    handle_app_msg(&m);
+    e.t = vnow + work_ns;
+    e.type = EV_APP_STEP;
+    des_post(&e);
 }
 
-static void preempt_current()
+// SIGCONT simulado: depois de um I/O começa o próximo PC; se o PC
+// terminou enquanto parado, segue logo (em um evento próprio, como o
+// app real que volta do sleep depois do kernel despachar)
+static void des_cont(pid_t pid)
 {
-    // Preempção do processo atual (SIGSTOP) e retorno à fila de PRONTOS
-    if (current == -1) return;
-    if (is_alive(current)) kill(current, SIGSTOP);
-    pcb_t *p = bypid(current);
-    if (p && p->st == ST_RUNNING) {
-        p->st = ST_READY;
-        rq_push(current);
+    pcb_t *p = bypid(pid);
+    if (!p) return;
+    des_app_t *a = &des_apps[p->app];
+    if (a->exited || a->running) return;
+    a->running = 1;
+    if (a->need_advance) {
+        a->need_advance = 0;
+        des_advance(p);
+    } else if (a->step_due) {
+        a->step_due = 0;
+        des_ev_t e = {.t = vnow, .type = EV_APP_STEP, .pid = pid};
+        des_post(&e);
     }
-    current = -1;
-    stall_ticks = 0;    // vai recomeçar em outro processo
-    log_ts_prefix();
-    printf(C_SCH "PREEMPT   <- %-3s (volta à fila de prontos)" C_RST "\n", p ? p->name : "?");
 }
 
-/* Inicia serviço de I/O se o dispositivo está livre */
-static void start_io_if_idle()
+// SIGSTOP simulado
+static void des_stop(pid_t pid)
 {
-    // Se D1 está livre, pega um bloqueado em I/O e inicia serviço (3s no IC)
-    if (io_busy) return;
-    pid_t p;
-    if (!io_pop(&p)) return;
-
-    io_busy = 1;
-    io_serving = p;
-
-    /* avisa o InterController: começa cronômetro de 3s */
-    icmsg_t m = {.msg_type = MSG_IO_START};
-    (void)write(fd_ic_w, &m, sizeof(m));
+    pcb_t *p = bypid(pid);
+    if (p) des_apps[p->app].running = 0;
+}
 
-    log_ts_prefix();
-    printf(C_IO "IO-START  >> %-3s (pid=%d) — D1 ocupado" C_RST "\n", name_of(p), (int)p);
+// Fim de um PC: segue o programa (ou espera o próximo CONT se parado)
+static void des_step(pcb_t *p)
+{
+    des_app_t *a = &des_apps[p->app];
+    if (!a->running) {
+        a->step_due = 1;
+        return;
+    }
+    des_advance(p);
 }
 
-/* ====== Comunicação com apps ====== */
-// Drena mensagens enviadas pelos apps (STATUS e SYSCALL)
-//  - STATUS: atualiza last_pc
-//  - SYSCALL: marca BLOCKED, enfileira em I/O e (se idle) dispara IO-START
-static void handle_app_pipe()
+// Loop do --des: consome eventos em ordem de instante até todos terminarem
+static void des_loop(void)
 {
-    for (;;) {
-        appmsg_t m;
-        ssize_t r = read(fd_app_r, &m, sizeof(m));
-        if (r < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
-            perror("read app pipe");
+    des_ev_t e = {.t = quantum_ns, .type = EV_TICK};
+    des_post(&e);
+    while (!all_done()) {
+        if (!des_pop(&e)) {
+            log_ts_prefix();
+            printf(C_ERR "DES       !! sem eventos pendentes e apps não finalizados" C_RST "\n");
             break;
         }
-        if (r == 0) break;
-        if (r != (ssize_t)sizeof(m)) continue;
-
-        pcb_t *p = bypid(m.pid);
-        if (!p) continue;
-
-        if (m.msg_type == MSG_SYSCALL_RW) {
-            // App pediu I/O: salva o tipo (R/W) no PCB para logs/restauração
-            p->last_syscall = (m.arg ? 1 : 0);
-
-            log_ts_prefix();
-            printf(C_IO "SYSCALL   !! %-3s pede I/O (%s)" C_RST "\n",
-                   name_of(m.pid), m.arg ? "WRITE" : "READ");
-
-            if (p->st == ST_RUNNING) {
-                kill(p->pid, SIGSTOP);
-                p->st = ST_BLOCKED;
-                if (current == p->pid) current = -1;
-                log_ts_prefix();
-                printf(C_IO "BLOCK     .. %-3s bloqueado por I/O [ctx: PC=%d, RW=%s]" C_RST "\n",
-                       name_of(p->pid), p->last_pc, p->last_syscall ? "W" : "R");
-            } else {
-                p->st = ST_BLOCKED;
+        vnow = e.t;
+        des_events++;
+        pcb_t *p = bypid(e.pid);
+        switch (e.type) {
+        case EV_TICK:
+            if (tickless) {
+                des_tick_posted = 0;
+                tick_catch_up(vnow);
+                break;
             }
-            io_push(p->pid);
-            start_io_if_idle();
-        }
-        else if (m.msg_type == MSG_APP_STATUS) {
-            // STATUS: último PC do app (usado no restore e para detectar stall)
-            p->last_pc = m.arg;   // mantém PC atualizado no contexto
-            if (current == p->pid) {
-                /* progresso do processo corrente: zera stall */
-                last_progress_pc = p->last_pc;
-                stall_ticks = 0;
+            tick_irqs++;
+            for (int c = 0; c < ncpus; c++) tick_cpu(c, vnow);
+            e.t = vnow + quantum_ns;
+            des_post(&e);
+            break;
+        case EV_IO_DONE:
+            io_complete(&e.cqe);
+            break;
+        case EV_APP_STEP:
+            if (p && !des_apps[p->app].exited) des_step(p);
+            break;
+        case EV_APP_EXIT:
+            if (p) {
+                des_apps[p->app].exited = 1;
+                proc_finished(p->pid);
             }
-            log_ts_prefix();
-            printf(C_APP "PC        :: %-3s -> %d" C_RST "\n", p->name, p->last_pc);
+            break;
+        case EV_ARRIVE:
+            admit_arrivals();
+            break;
+        }
+        dispatch_idle();
+        if (kst && (des_events & 255) == 0) stats_tick();
+        if (tickless && !des_tick_posted && tick_want() != TK_OFF) {
+            // --tickless: o último tick foi com tudo ocioso; a grade volta
+            // depois deste instante (um tick em vnow viria antes do evento)
+            if (tick_next <= vnow) {
+                long long k = (vnow - tick_next) / quantum_ns + 1;
+                tick_skipped += k;
+                tick_next += k * quantum_ns;
+            }
+            des_ev_t t = {.t = tick_next, .type = EV_TICK};
+            des_post(&t);
+            des_tick_posted = 1;
         }
     }
+    end_ns = now_ns();
+    report_loop_cost();
+    write_report();
+    if (kst) stats_publish(1);
+    log_ts_prefix();
+    printf(C_SCH "TERMINOU: todos os apps finalizaram; encerrando Kernel" C_RST "\n");
 }
 
-/* ====== Reaper ====== */
-// trata término de filhos, marca FINISHED e remove de filas
-static void on_child_exit()
+/* ====== Criação e admissão de apps ====== */
+// Argumentos do ./app do app i na vaga `slot`; i < 0 cria um zigoto
+// (--zygote: nome, índice e programa chegam depois pela vaga)
+typedef struct {
+    char *av[16];
+    char fdw[16], name[MAX_NAME], idx[16], kpid[16];
+    char work[48], ring[48], park[48], zyg[48], aio[48], compute[48];
+    char *prog;
+} app_args_t;
+
+static void app_args(app_args_t *a, int i, int slot)
 {
-    int status;
-    pid_t pid;
-    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
-        pcb_t *p = bypid(pid);
-        if (p && p->st != ST_FINISHED) {
-            p->st = ST_FINISHED;
-            finished_count++;
-
-            if (current == pid) current = -1;
-
-            /* remova de todas as filas para não despachar de novo */
-            rq_remove_pid(pid);
-            io_remove_pid(pid);
+    int ac = 0;
+    snprintf(a->fdw, sizeof(a->fdw), "%d", fd_app_w);
+    snprintf(a->idx, sizeof(a->idx), "%d", i + 1);
+    snprintf(a->name, sizeof(a->name), "%s", i >= 0 ? wload[i].name : "Z");
+    snprintf(a->kpid, sizeof(a->kpid), "%d", (int)getpid());
+    snprintf(a->work, sizeof(a->work), "--work-ns=%lld", work_ns);
+    a->prog = NULL;
+    a->av[ac++] = "./app";
+    a->av[ac++] = a->work;
+    if (work_mode != WORK_SLEEP) {
+        snprintf(a->compute, sizeof(a->compute), "--compute=%s,%lld", work_names[work_mode], work_iters);
+        a->av[ac++] = a->compute;
+    }
+    if (ring) {
+        snprintf(a->ring, sizeof(a->ring), "--ring=%d,%d", ring_fd, bell_fd);
+        a->av[ac++] = a->ring;
+    }
+    if (park) {
+        snprintf(a->park, sizeof(a->park), "--park=%d,%d", park_fd, slot);
+        a->av[ac++] = a->park;
+    }
+    if (kaio && slot >= 0) {
+        snprintf(a->aio, sizeof(a->aio), "--aio=%d,%d", kaio_fd, slot);
+        a->av[ac++] = a->aio;
+    }
+    if (i < 0) {
+        snprintf(a->zyg, sizeof(a->zyg), "--zygote=%d,%d", zyg_fd, slot);
+        a->av[ac++] = a->zyg;
+    } else if (asprintf(&a->prog, "--prog=%s", wload[i].text) > 0) {
+        a->av[ac++] = a->prog;
+    } else {
+        a->prog = NULL;
+    }
+    a->av[ac++] = a->fdw;
+    a->av[ac++] = a->name;
+    a->av[ac++] = a->idx;
+    a->av[ac++] = a->kpid;
+    a->av[ac] = NULL;
+}
 
-            log_ts_prefix();
-            printf(C_APP "FINISHED  xx %-3s (pid=%d)" C_RST "\n", p->name, (int)pid);
+// Cria o processo do app i (ou um zigoto, i < 0) na vaga `slot`: fork +
+// exec ou posix_spawn. Os descritores só do kernel são CLOEXEC. -1 em erro
+static pid_t spawn_app(int i, int slot)
+{
+    app_args_t a;
+    app_args(&a, i, slot);
+    pid_t pid = -1;
+    if (spawn_mode == SP_FORK && i >= 0) {
+        pid = fork();
+        if (pid == 0) {
+            sigprocmask(SIG_SETMASK, &app_mask, NULL);
+            execv("./app", a.av);
+            perror("exec app");
+            _exit(1);
+        }
+    } else {
+        int err = posix_spawn(&pid, "./app", NULL, &spawn_attr, a.av, environ);
+        if (err) {
+            errno = err;
+            pid = -1;
         }
     }
+    if (pid < 0) perror("spawn app");
+    free(a.prog);
+    return pid;
 }
 
-/* ====== Critério de parada ====== */
-// todos finalizaram e não há nada em filas/serviço
-static int all_done(void)
+// Tira uma vaga livre, com portão fechado, contador de I/O assíncrono
+// zerado e sem tarefa; -1 se esgotaram
+static int slot_alloc(void)
 {
-    return (finished_count == nprocs) && (rq_count == 0) && (current == -1)
-           && (io_busy == 0) && (io_count == 0);
+    if (nslot_free == 0) return -1;
+    int s = slot_free[--nslot_free];
+    if (park) atomic_store(&park[s].gate, PARK_STOP);
+    if (kaio) kaio_publish(&kaio[s], 0);
+    if (zyg) zyg_reset(&zyg[s]);
+    return s;
 }
 
-/* ====== Loop principal ====== */
-// reage a eventos e mantém a política de escalonamento
-// Ordem de reação:
-//   1) drena pipe de apps
-//   2) IRQ1 (fim de I/O) — desbloqueia e redispatch
-//   3) IRQ0 (timer) — preempta se houver disputa; único pronto continua
-//   4) SIGALRM (nudge) — se CPU ociosa, despacha
-//   5) coleta filhos terminados; checa critério de parada
-static void schedule_loop()
+// Completa a reserva com até `max` zigotos; retorna quantos criou
+static int pool_fill(int max)
 {
-    for (;;) {
-        handle_app_pipe();
-
-        // Fim de I/O: libera o processo bloqueado e tenta reiniciar próximo serviço
-        if (got_irq1) {
-            got_irq1 = 0;
-            log_ts_prefix();
-            printf(C_IRQ "IRQ1      ** D1 sinaliza término de I/O" C_RST "\n");
-
-            io_busy = 0;
-            if (io_serving != -1) {
-                pcb_t *p = bypid(io_serving);
-                if (p && p->st == ST_BLOCKED) {
-                    p->st = ST_READY;
-                    rq_push(p->pid);
-                    log_ts_prefix();
-                    printf(C_IO "IO-DONE   << %-3s liberado; volta à fila de prontos" C_RST "\n", p->name);
-                }
-                io_serving = -1;
-            }
-            start_io_if_idle();
-            dispatch_next();
+    int made = 0;
+    while (zyg && pool_n < pool_target && made < max) {
+        int s = slot_alloc();
+        if (s < 0) break;
+        pid_t pid = spawn_app(-1, s);
+        if (pid < 0) {
+            slot_free[nslot_free++] = s;
+            break;
         }
+        pool[pool_n++] = (zygote_t){pid, s, track_exit(pid)};
+        made++;
+    }
+    return made;
+}
 
-        // Tick do timer (IRQ0): decide entre manter atual ou preemptar, conforme disputa
-        if (got_irq0) {
-            got_irq0 = 0;
+// Um zigoto morreu antes de receber tarefa: sai da reserva
+static void pool_forget(pid_t pid)
+{
+    for (int j = 0; j < pool_n; j++) {
+        if (pool[j].pid != pid) continue;
+        slot_free[nslot_free++] = pool[j].slot;
+        if (pool[j].pidfd >= 0) close(pool[j].pidfd);
+        pool[j] = pool[--pool_n];
+        return;
+    }
+}
 
-            if (current != -1 && rq_count == 0) {
-                /* Único pronto: não preempta — MAS reforça CONT e vigia stall */
-                log_ts_prefix();
-                printf(C_IRQ "IRQ0      ** time-slice encerrado — único pronto continua" C_RST "\n");
-
-                /* 1) Reforço: se ficou parado em SIGSTOP por corrida, acorda */
-                kill(current, SIGCONT);
-
-                /* 2) Watchdog: se não há progresso de PC, conta stall */
-                pcb_t *cp = bypid(current);
-                if (cp) {
-                    if (cp->last_pc == last_progress_pc) {
-                        stall_ticks++;
-                    } else {
-                        last_progress_pc = cp->last_pc;
-                        stall_ticks = 0;
-                    }
-                }
-
-                /* 3) Se 5 ticks sem progresso, “nudge”: STOP -> fila -> DISPATCH */
-                if (stall_ticks >= 5 && cp) {
-                    log_ts_prefix();
-                    printf(C_ERR "NUDGE     !! sem progresso (%d ticks) — reativando %s" C_RST "\n",
-                           stall_ticks, name_of(current));
-                    if (is_alive(current)) kill(current, SIGSTOP);
-                    cp->st = ST_READY;
-                    rq_push(current);
-                    current = -1;
-                    stall_ticks = 0;
-                    dispatch_next();
-                }
-            } else {
-                /* Há 2+ prontos: preempta normalmente */
-                log_ts_prefix();
-                printf(C_IRQ "IRQ0      ** time-slice encerrado" C_RST "\n");
-                preempt_current();
-                dispatch_next();
-            }
-        }
+// Encerramento: termina os zigotos que sobraram
+static void pool_drain(void)
+{
+    for (int j = 0; j < pool_n; j++) pidfd_signal(pool[j].pid, pool[j].pidfd, SIGKILL);
+    for (int j = 0; j < pool_n; j++) {
+        waitpid(pool[j].pid, NULL, 0);
+        if (pool[j].pidfd >= 0) close(pool[j].pidfd);
+    }
+    pool_n = 0;
+}
 
-        if (got_sysc) {
-            got_sysc = 0;
-            if (current == -1) dispatch_next();
+// Cria o processo do app i, já parado (sem PC antes do primeiro
+// DISPATCH): zigoto da reserva ou criação direta. PID ou -1
+static pid_t launch_app(int i, int *slot_out, int *pidfd_out)
+{
+    long long t0 = real_ns();
+    pid_t pid = -1;
+    int slot = -1;
+    if (zyg && pool_n > 0 && strlen(wload[i].text) < ZYG_PROG_MAX) {
+        zygote_t z = pool[--pool_n];
+        pid = z.pid;
+        slot = z.slot;
+        *pidfd_out = z.pidfd;
+        // parado antes de acordar: só passa do futex depois do SIGCONT
+        if (!park) pidfd_signal(pid, z.pidfd, SIGSTOP);
+        zyg_assign(&zyg[slot], i + 1, wload[i].name, wload[i].text);
+    } else {
+        if (zyg) pool_miss++;
+        if ((slot = slot_alloc()) >= 0 && (pid = spawn_app(i, slot)) < 0) {
+            slot_free[nslot_free++] = slot;
+            slot = -1;
         }
+        /* Congela imediatamente o filho recém-criado para não haver
+           “PC ::” antes do primeiro DISPATCH (com portões o app já nasce
+           parado no seu portão) */
+        if (pid > 0) *pidfd_out = track_exit(pid);
+        if (pid > 0 && !park) pidfd_signal(pid, *pidfd_out, SIGSTOP);
+    }
+    long long dt = real_ns() - t0;
+    if (pid > 0) {
+        spawn_count++;
+        spawn_ns += dt;
+        if (dt > spawn_max_ns) spawn_max_ns = dt;
+    }
+    *slot_out = slot;
+    return pid;
+}
 
-        on_child_exit();
+// Cria o PCB do app i (nome, peso e afinidade de wload[i]) e o põe na
+// fila de prontos. A chegada conta do instante previsto, então o custo
+// de criar o processo aparece no tempo de resposta.
+static pcb_t *admit_app(pid_t pid, int i, int slot, int pidfd)
+{
+    pcb_t *pp = pt_add(&pt, pid);
+    nprocs++;
+    snprintf(pp->name, sizeof(pp->name), "%s", wload[i].name);
+    pp->app = i;
+    pp->slot = slot;
+    pp->pidfd = pidfd;
+    pp->st = ST_READY;
+    pp->t_state = now_ns();
+    pp->t_arrival = (des ? 0 : boot_ns) + wload[i].arrival_ns;
+    if (pp->t_arrival > pp->t_state) pp->t_arrival = pp->t_state;
+    pp->t_first_run = -1;
+    pp->last_pc = 0;
+    pp->last_syscall = -1;   /* parâmetro de syscall salvo no contexto */
+    pp->io_dev = -1;
+    pp->heap_pos = -1;
+    pp->weight = wload[i].weight;
+    pp->affinity = wload[i].affinity;
+    pp->cpu = -1;
+    pp->host_cpu = -1;
+    if (!des && clock_getcpuclockid(pid, &pp->clk) == 0) {
+        pp->clk_ok = 1;
+        cpu_measure(pp);   // base: a primeira cobrança mede só dali em diante
+    }
+    rq_wake(pp);
+    return pp;
+}
 
-        if (all_done()) {
-            log_ts_prefix();
-            printf(C_SCH "TERMINOU: todos os apps finalizaram; encerrando Kernel e IC" C_RST "\n");
-            if (ic_pid > 0) kill(ic_pid, SIGTERM);
-            if (ic_pid > 0) waitpid(ic_pid, NULL, 0);
+// Admite (cria + SPAWN) os apps cuja chegada já passou e agenda a
+// próxima: evento no --des, timerfd absoluto no modo real. No modo real,
+// no máximo ADMIT_BATCH por rodada: uma rajada de chegadas não segura
+// o loop (IRQs, mensagens) até todos os processos existirem.
+static void admit_arrivals(void)
+{
+    long long t = log_ns(), t0 = real_ns();
+    int batch = 0;
+    while (arr_next < napps_total && wload[arr_order[arr_next]].arrival_ns <= t) {
+        if (!des && batch++ == ADMIT_BATCH) {
+            got_arr = 1;  // o resto na próxima rodada, sem dormir
             break;
         }
+        int i = arr_order[arr_next++], slot = -1, pidfd = -1;
+        pid_t pid = des ? 1000 + i : launch_app(i, &slot, &pidfd);
+        if (pid < 0 && nslot_free == 0) {
+            // a criação falhou antes do fork: sem vaga (portão, kaio, zigoto)
+            fprintf(stderr, C_ERR "Erro: não foi possível criar %s: vagas esgotadas (%d apps vivos;"
+                    " o --ctl reserva %d além dos apps do boot; aumente com --ctl-slots)." C_RST "\n",
+                    wload[i].name, nprocs - finished_count, ctl_slots);
+            continue;
+        }
+        if (pid < 0) {
+            fprintf(stderr, C_ERR "Erro: não foi possível criar %s." C_RST "\n", wload[i].name);
+            continue;
+        }
+        pcb_t *pp = admit_app(pid, i, slot, pidfd);
+        kev(TR_SPAWN, -1, pp->pid, 0, 0, 0, 0);
+    }
+    if (!des && real_ns() - t0 > admit_max_ns) admit_max_ns = real_ns() - t0;
+    if (arr_next == napps_total || got_arr) return;
+    long long at = wload[arr_order[arr_next]].arrival_ns;
+    if (des) {
+        des_ev_t e = {.t = at, .type = EV_ARRIVE};
+        des_post(&e);
+    } else if (arr_fd >= 0) {
+        at += boot_ns;
+        struct itimerspec its = {.it_value = {.tv_sec = at / 1000000000LL, .tv_nsec = at % 1000000000LL}};
+        timerfd_settime(arr_fd, TFD_TIMER_ABSTIME, &its, NULL);
+    }
+}
+
+// Acrescenta um app à carga e o põe na ordem de chegada (--ctl)
+static void add_app(const wl_app_t *a)
+{
+    if (napps_total == wload_cap) {
+        wload_cap = wload_cap ? 2 * wload_cap : 16;
+        wload = realloc(wload, (size_t)wload_cap * sizeof(wl_app_t));
+        arr_order = realloc(arr_order, (size_t)wload_cap * sizeof(int));
+        if (!wload || !arr_order) { perror("ctl"); exit(1); }
+    }
+    int i = napps_total++;
+    wload[i] = *a;
+    int k = napps_total - 1;
+    while (k > arr_next && wload[arr_order[k - 1]].arrival_ns > a->arrival_ns) {
+        arr_order[k] = arr_order[k - 1];
+        k--;
+    }
+    arr_order[k] = i;
+}
 
-        if (current == -1) dispatch_next();
+// Um comando do --ctl (linha sem '\n')
+static void ctl_command(char *s)
+{
+    while (isspace((unsigned char)*s)) s++;
+    if (!*s || *s == '#') return;
+    if (strncmp(s, "end", 3) == 0 && (!s[3] || isspace((unsigned char)s[3]))) {
+        if (!ctl_open) return;
+        ctl_open = 0;
+        log_ts_prefix();
+        printf(C_SCH "CTL       ~~ fim das admissões (%d apps no total)" C_RST "\n", napps_total);
+        return;
+    }
+    wl_app_t a;
+    if (strncmp(s, "spawn ", 6) != 0 || !ctl_open) {
+        fprintf(stderr, C_ERR "ctl: comando ignorado: %.40s" C_RST "\n", s);
+        return;
+    }
+    if (!wl_parse_line(s + 6, time_scale, &a)) {
+        fprintf(stderr, C_ERR "ctl: esperado spawn <nome> <atraso_ms> <passos...>" C_RST "\n");
+        return;
+    }
+    a.arrival_ns += log_ns();
+    a.weight = 1;
+    a.affinity = -1;
+    add_app(&a);
+    admit_arrivals();
+}
 
-        usleep(10000);
+// Lê os comandos disponíveis no FIFO do --ctl (linhas completas)
+static void ctl_read(void)
+{
+    for (;;) {
+        ssize_t r = read(ctl_fd, ctl_buf + ctl_len, sizeof(ctl_buf) - 1 - ctl_len);
+        if (r <= 0) break;
+        ctl_len += (size_t)r;
+        char *nl;
+        while ((nl = memchr(ctl_buf, '\n', ctl_len)) != NULL) {
+            *nl = '\0';
+            ctl_command(ctl_buf);
+            size_t used = (size_t)(nl + 1 - ctl_buf);
+            memmove(ctl_buf, nl + 1, ctl_len - used);
+            ctl_len -= used;
+        }
+        if (ctl_len == sizeof(ctl_buf) - 1) ctl_len = 0; // linha longa demais
     }
 }
 
+// Próximo valor de uma lista "a,b,c" (o último vale para os demais)
+static int list_next(const char **l)
+{
+    int v = atoi(*l);
+    const char *comma = strchr(*l, ',');
+    if (comma) *l = comma + 1;
+    return v;
+}
+
+// Chegada mais cedo primeiro; empate pelo índice do app
+static int cmp_arrival(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    if (wload[x].arrival_ns != wload[y].arrival_ns) return wload[x].arrival_ns < wload[y].arrival_ns ? -1 : 1;
+    return x - y;
+}
 
 // Mensagem de uso para parâmetros inválidos
 static void usage(const char *argv0)
 {
-    fprintf(stderr, "Uso: %s <num_apps (3..6)>\n", argv0);
+    fprintf(stderr,
+            "Uso: %s [opções] <num_apps (>= 1; enunciado: 3..6; opcional com --workload)>\n"
+            "  --workload F     programas e chegadas dos apps (ver workload.h e ./wlgen);\n"
+            "                   com num_apps, usa só os primeiros\n"
+            "  --ctl FIFO       admite apps em execução: linhas \"spawn <nome> <atraso_ms>\n"
+            "                   <passos...>\" e \"end\" (num_apps opcional; cria o FIFO)\n"
+            "  --ctl-slots N    apps do --ctl vivos ao mesmo tempo: vagas reservadas\n"
+            "                   nas áreas compartilhadas (padrão: 1024)\n"
+            "  --spawn fork|posix|pool  criação dos apps na chegada: fork+exec,\n"
+            "                   posix_spawn ou reserva de zigotos (padrão: fork)\n"
+            "  --pool N         tamanho da reserva do --spawn pool (padrão: 32)\n"
+            "  --ipc pipe|shm   transporte app->kernel (padrão: pipe)\n"
+            "  --switch signal|park  troca de contexto: SIGSTOP/SIGCONT ou portões\n"
+            "                   com futex em memória compartilhada (padrão: signal)\n"
+            "  --devices N      número de dispositivos de I/O (padrão: 1)\n"
+            "  --io-ms a[,b..]  tempo de serviço por dispositivo em ms (padrão: 3000)\n"
+            "  --disk-sched S   fifo | sstf | scan | clook | deadline: cada dispositivo\n"
+            "                   vira um disco (seek pela distância da cabeça + transferência;\n"
+            "                   --io-ms é o seek de ponta a ponta) e junta pedidos vizinhos\n"
+            "                   (padrão: --io-ms fixo por pedido, em ordem de chegada)\n"
+            "  --quantum-ms Q   time-slice / período do IRQ0 em ms (padrão: 1000)\n"
+            "  --work-ms W      duração de um PC dos apps em ms (padrão: 1000)\n"
+            "  --work sleep|spin|mem  o que o app faz num PC: dorme, faz contas ou\n"
+            "                   percorre memória (spin/mem: CPU real, calibrada no boot\n"
+            "                   para W ms; a política é cobrada pela CPU medida)\n"
+            "  --time-scale S   divide todos os tempos acima por S (padrão: 1)\n"
+            "  --policy P       rr | mlfq | prio | stride | lottery | cfs | sjf | srtf\n"
+            "                   (padrão: rr; sjf/srtf pela rajada de CPU estimada)\n"
+            "  --adaptive       fatia de cada dispatch pela rajada de CPU estimada do\n"
+            "                   processo, de 1 a 8 quanta (rr, lottery, sjf, srtf)\n"
+            "  --weights a[,b..] peso de A1, A2, ...: prioridade, bilhetes/100 ou\n"
+            "                   peso CFS conforme a política (padrão: 1)\n"
+            "  --cpus N         núcleos simulados, cada um com sua fila (padrão: 1)\n"
+            "  --affinity a[,b..] núcleo fixo de A1, A2, ... (1..N; 0 = qualquer)\n"
+            "  --report-json F  grava métricas por processo, núcleo e dispositivo em JSON\n"
+            "  --report-csv F   grava métricas por processo em CSV\n"
+            "  --trace F        grava os eventos em binário (anel + thread escritora)\n"
+            "                   em vez do log em texto; ./ktrace F reconstrói o log\n"
+            "  --chrome F       grava a linha do tempo (CPUs, apps, dispositivos, IRQs)\n"
+            "                   em JSON do Chrome Trace / Perfetto\n"
+            "  --des            simulação de eventos discretos em tempo virtual\n"
+            "                   (sem processos nem sinais; mesma lógica de escalonamento)\n"
+            "  --coro           --des com cada app rodando como corrotina no próprio\n"
+            "                   kernel (troca em assembly no x86-64, ucontext nas\n"
+            "                   demais arquiteturas); escala para 100k+ apps\n"
+            "  --tickless       IRQ0 só quando há disputa por um núcleo; ocioso, o\n"
+            "                   timer para (mesmo escalonamento, menos interrupções)\n"
+            "  --stats F        publica o estado ao vivo em memória compartilhada no\n"
+            "                   arquivo F (ex.: /dev/shm/ksim); ./kstat F mostra\n",
+            argv0);
     exit(1);
 }
 
@@ -445,21 +2838,294 @@ static void usage(const char *argv0)
 // - Cria pipes
 // - Forca o InterController (IC)
 // - Configura handlers
-// - Forca os apps A1..An e os coloca em PRONTOS
-// - Pausa todos e inicia o loop de escalonamento
+// - Cria os apps (--spawn) no instante de chegada de cada um, parados,
+//   e os coloca em PRONTOS
+// - Inicia o loop de escalonamento
 int main(int argc, char **argv)
 {
-    t0 = time(NULL);
+    boot_ns = real_ns();
     setvbuf(stdout, NULL, _IOLBF, 0); // flush por linha (macOS)
 
-    if (argc < 2) usage(argv[0]);
+    static const struct option lopts[] = {
+        {"ipc", required_argument, NULL, 'i'},
+        {"switch", required_argument, NULL, 'S'},
+        {"devices", required_argument, NULL, 'd'},
+        {"io-ms", required_argument, NULL, 'o'},
+        {"policy", required_argument, NULL, 'p'},
+        {"weights", required_argument, NULL, 'w'},
+        {"cpus", required_argument, NULL, 'c'},
+        {"affinity", required_argument, NULL, 'a'},
+        {"des", no_argument, NULL, 'D'},
+        {"coro", no_argument, NULL, 'R'},
+        {"quantum-ms", required_argument, NULL, 'q'},
+        {"work-ms", required_argument, NULL, 'W'},
+        {"time-scale", required_argument, NULL, 's'},
+        {"report-json", required_argument, NULL, 'J'},
+        {"report-csv", required_argument, NULL, 'C'},
+        {"trace", required_argument, NULL, 'T'},
+        {"chrome", required_argument, NULL, 'G'},
+        {"workload", required_argument, NULL, 'L'},
+        {"ctl", required_argument, NULL, 'K'},
+        {"spawn", required_argument, NULL, 'P'},
+        {"pool", required_argument, NULL, 'Z'},
+        {"tickless", no_argument, NULL, 'N'},
+        {"disk-sched", required_argument, NULL, 'X'},
+        {"stats", required_argument, NULL, 'M'},
+        {"adaptive", no_argument, NULL, 'A'},
+        {"work", required_argument, NULL, 'k'},
+        {"ctl-slots", required_argument, NULL, 'V'},
+        {NULL, 0, NULL, 0},
+    };
+    const char *io_ms_list = "3000";
+    const char *weights = "1";
+    const char *affinity = "0";
+    double quantum_ms = 1000, work_ms = 1000;
+    sched = &policies[0];
+    int opt;
+    while ((opt = getopt_long(argc, argv, "i:S:d:o:p:w:c:a:ADRNq:W:s:J:C:T:G:L:K:P:Z:X:M:k:V:", lopts, NULL)) != -1) {
+        switch (opt) {
+        case 'i':
+            if (strcmp(optarg, "pipe") == 0) ipc_mode = IPC_PIPE;
+            else if (strcmp(optarg, "shm") == 0) ipc_mode = IPC_SHM;
+            else usage(argv[0]);
+            break;
+        case 'S':
+            if (strcmp(optarg, "signal") == 0) switch_mode = SW_SIGNAL;
+            else if (strcmp(optarg, "park") == 0) switch_mode = SW_PARK;
+            else usage(argv[0]);
+            break;
+        case 'd':
+            ndevs = atoi(optarg);
+            if (ndevs < 1) usage(argv[0]);
+            break;
+        case 'o':
+            io_ms_list = optarg;
+            break;
+        case 'p':
+            sched = NULL;
+            for (size_t k = 0; k < sizeof(policies) / sizeof(policies[0]); k++)
+                if (strcmp(optarg, policies[k].name) == 0) sched = &policies[k];
+            if (!sched) usage(argv[0]);
+            break;
+        case 'w':
+            weights = optarg;
+            break;
+        case 'c':
+            ncpus = atoi(optarg);
+            if (ncpus < 1) usage(argv[0]);
+            break;
+        case 'a':
+            affinity = optarg;
+            break;
+        case 'D':
+            des = 1;
+            break;
+        case 'R':
+            des = coro = 1;
+            break;
+        case 'N':
+            tickless = 1;
+            break;
+        case 'A':
+            adaptive = 1;
+            break;
+        case 'k':
+            work_mode = -1;
+            for (int m = WORK_SLEEP; m <= WORK_MEM; m++)
+                if (strcmp(optarg, work_names[m]) == 0) work_mode = m;
+            if (work_mode < 0) usage(argv[0]);
+            break;
+        case 'X':
+            disk_sched = DS_NONE;
+            for (int k = DS_FIFO; k <= DS_DEADLINE; k++)
+                if (strcmp(optarg, disk_names[k]) == 0) disk_sched = k;
+            if (disk_sched == DS_NONE) usage(argv[0]);
+            break;
+        case 'q':
+            quantum_ms = atof(optarg);
+            if (quantum_ms <= 0) usage(argv[0]);
+            break;
+        case 'W':
+            work_ms = atof(optarg);
+            if (work_ms <= 0) usage(argv[0]);
+            break;
+        case 's':
+            time_scale = atof(optarg);
+            if (time_scale <= 0) usage(argv[0]);
+            break;
+        case 'J':
+            report_json = optarg;
+            break;
+        case 'M':
+            stats_path = optarg;
+            break;
+        case 'C':
+            report_csv = optarg;
+            break;
+        case 'T':
+            trace_path = optarg;
+            break;
+        case 'G':
+            chrome_path = optarg;
+            break;
+        case 'L':
+            workload_path = optarg;
+            break;
+        case 'K':
+            ctl_path = optarg;
+            break;
+        case 'V':
+            ctl_slots = atoi(optarg);
+            if (ctl_slots < 1) usage(argv[0]);
+            break;
+        case 'P':
+            spawn_mode = -1;
+            for (int m = 0; m < 3; m++)
+                if (strcmp(optarg, spawn_names[m]) == 0) spawn_mode = m;
+            if (spawn_mode < 0) usage(argv[0]);
+            break;
+        case 'Z':
+            pool_target = atoi(optarg);
+            if (pool_target < 1) usage(argv[0]);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (optind >= argc && !workload_path && !ctl_path) usage(argv[0]);
+    if (ctl_path && des) {
+        fprintf(stderr, C_ERR "Erro: --ctl não combina com --des (tempo virtual)." C_RST "\n");
+        return 1;
+    }
+    if (des && work_mode != WORK_SLEEP) {
+        fprintf(stderr, C_ERR "Erro: --work %s precisa de processos reais (sem --des)." C_RST "\n",
+                work_names[work_mode]);
+        return 1;
+    }
+    if (adaptive && sched->tick != rr_tick && sched->tick != sjf_tick && sched->tick != srtf_tick) {
+        fprintf(stderr, C_ERR "Erro: --adaptive vale para rr, lottery, sjf e srtf (%s já tem fatia própria)." C_RST "\n",
+                sched->name);
+        return 1;
+    }
 
-    nprocs = atoi(argv[1]);
-    if (nprocs < 3 || nprocs > 6) {
-        fprintf(stderr, C_ERR "Erro: número de apps precisa estar entre 3 e 6 (conforme enunciado)." C_RST "\n");
+    int napps = optind < argc ? atoi(argv[optind]) : 0;
+    if (optind < argc && napps < 1) {
+        fprintf(stderr, C_ERR "Erro: número de apps precisa ser >= 1." C_RST "\n");
         usage(argv[0]);
     }
 
+    // Programas: do arquivo (--workload) ou os fixos do enunciado
+    if (workload_path) {
+        int n = wl_load(workload_path, time_scale, &wload);
+        if (n < 0) return 1;
+        if (napps > n) {
+            fprintf(stderr, C_ERR "Erro: %s tem só %d apps." C_RST "\n", workload_path, n);
+            return 1;
+        }
+        if (napps == 0) napps = n;
+    } else {
+        wload = calloc((size_t)napps + 1, sizeof(wl_app_t));
+        if (!wload) { perror("workload"); return 1; }
+        for (int i = 0; i < napps; i++) wl_builtin(i + 1, &wload[i]);
+    }
+    napps_total = wload_cap = napps;
+    pt_init(&pt, napps);
+
+    quantum_ns = (long long)(quantum_ms * 1e6 / time_scale);
+    work_ns = (long long)(work_ms * 1e6 / time_scale);
+    if (quantum_ns < 1000) quantum_ns = 1000;  // 1 us
+    if (work_ns < 1000) work_ns = 1000;
+    // um app sozinho só reporta progresso a cada PC: o vigia espera 5 PCs
+    long long wait_ns = 5 * work_ns;
+    if (wait_ns > stall_limit * quantum_ns) stall_limit = (int)((wait_ns + quantum_ns - 1) / quantum_ns);
+    log_ms = quantum_ns < 1000000000LL || work_ns < 1000000000LL;
+
+    // --work spin|mem: iterações que custam work_ns de CPU nesta máquina,
+    // antes de criar qualquer app (também os zigotos da reserva)
+    if (work_mode != WORK_SLEEP && (work_iters = work_calibrate(work_mode, work_ns)) <= 0) {
+        perror("work");
+        return 1;
+    }
+
+    // Núcleos simulados, mapeados em rodízio sobre as CPUs reais
+    cpus = calloc((size_t)ncpus, sizeof(cpu_t));
+    if (!cpus) { perror("cpus"); return 1; }
+    long nhost = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nhost < 1) nhost = 1;
+    for (int c = 0; c < ncpus; c++) {
+        cpus[c].current = -1;
+        cpus[c].last_progress_pc = -1;
+        cpus[c].host_cpu = (int)(c % nhost);
+        runq_init(&cpus[c].rq);
+    }
+
+    // Dispositivos: tempos da lista --io-ms; o último vale para os demais
+    devs = calloc((size_t)ndevs, sizeof(device_t));
+    if (!devs) { perror("devs"); return 1; }
+    const char *ms = io_ms_list;
+    for (int d = 0; d < ndevs; d++) {
+        devs[d].q = (ioq_t){.head = -1, .tail = -1};
+        devs[d].serving = -1;
+        devs[d].dir = 1;
+        devs[d].service_ns = (long long)(atof(ms) * 1e6 / time_scale);
+        if (devs[d].service_ns < 0) devs[d].service_ns = 0;
+        const char *comma = strchr(ms, ',');
+        if (comma) ms = comma + 1;
+    }
+
+    // --weights / --affinity por índice do app; ordem de chegada
+    const char *wl = weights, *al = affinity;
+    arr_order = calloc((size_t)napps + 1, sizeof(int));
+    if (!arr_order) { perror("apps"); return 1; }
+    for (int i = 0; i < napps; i++) {
+        wload[i].weight = list_next(&wl);
+        if (wload[i].weight < 1) wload[i].weight = 1;
+        wload[i].affinity = list_next(&al) - 1; /* 0 = qualquer núcleo */
+        if (wload[i].affinity >= ncpus) wload[i].affinity = -1;
+        arr_order[i] = i;
+    }
+    qsort(arr_order, (size_t)napps, sizeof(int), cmp_arrival);
+
+    log_hdr.ncpus = ncpus;
+    log_hdr.log_ms = log_ms;
+    log_hdr.des = des;
+    strncpy(log_hdr.policy, sched->name, sizeof(log_hdr.policy) - 1);
+
+    if (stats_path) {
+        kst = ks_create(stats_path, (uint32_t)napps + KS_SLACK);
+        if (!kst) { perror(stats_path); return 1; }
+    }
+
+    // --des: apps simulados em tempo virtual; nada de pipes, IC ou fork
+    if (des) {
+        des_apps = calloc((size_t)napps, sizeof(des_app_t));
+        if (!des_apps) { perror("des"); return 1; }
+        if (coro) {
+            coros = calloc((size_t)napps, sizeof(coro_app_t));
+            coro_stacks = task_arena((size_t)napps);
+            if (!coros || !coro_stacks) { perror("coro"); return 1; }
+            for (int i = 0; i < napps; i++) coros[i].app = i;
+        }
+        setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+        trace_start();
+        tick_next = quantum_ns;
+        log_ts_prefix();
+        printf(C_SCH "BOOT      ~~ KernelSim iniciando (%d apps, política %s%s, %d CPU%s, DES%s)" C_RST "\n",
+               napps, sched->name, adaptive ? " adaptativa" : "", ncpus, ncpus > 1 ? "s" : "",
+               coro ? ", corrotinas" : "");
+        for (int i = 0; i < napps; i++) {
+            des_apps[i].need_advance = 1;
+            wl_start(&des_apps[i].cur, i + 1);
+        }
+        admit_arrivals();
+        dispatch_idle();
+        des_loop();
+        trace_stop();
+        log_ts_prefix();
+        printf(C_SCH "SHUTDOWN  ~~ Kernel encerrado\n" C_RST);
+        return 0;
+    }
+
     // Cria pipes de IPC e coloca fd_app_r em não-bloqueante
     /* pipes app->kernel */
     int p_app[2];
@@ -467,89 +3133,159 @@ int main(int argc, char **argv)
     fd_app_r = p_app[0];
     fd_app_w = p_app[1];
     set_nonblock(fd_app_r);
+    fcntl(fd_app_r, F_SETFD, FD_CLOEXEC); /* posix_spawn não fecha nada */
+
+    /* vagas de processo: uma por app, zigoto e app do --ctl */
+    int nslots = napps + (spawn_mode == SP_POOL ? pool_target : 0) + (ctl_path ? ctl_slots : 0);
+    slot_free = calloc((size_t)nslots, sizeof(int));
+    if (!slot_free) { perror("slots"); return 1; }
+    for (int s = nslots - 1; s >= 0; s--) slot_free[nslot_free++] = s;
+
+    /* anel app->kernel em memória compartilhada (--ipc shm) */
+    if (ipc_mode == IPC_SHM) {
+        ring = msgring_create((uint32_t)(nslots * 8), &ring_fd);
+        bell_fd = eventfd(0, EFD_NONBLOCK);
+        if (!ring || bell_fd < 0) { perror("msgring"); return 1; }
+    }
+
+    /* portões de estacionamento (--switch park), todos fechados */
+    if (switch_mode == SW_PARK && !(park = park_create(nslots, &park_fd))) {
+        perror("park");
+        return 1;
+    }
+
+    /* contadores de I/O assíncrono (kaio.h), um por vaga */
+    if (!(kaio = kaio_create(nslots, &kaio_fd))) {
+        perror("kaio");
+        return 1;
+    }
+
+    /* reserva de zigotos (--spawn pool) */
+    if (spawn_mode == SP_POOL) {
+        zyg = zyg_create(nslots, &zyg_fd);
+        pool = calloc((size_t)pool_target, sizeof(zygote_t));
+        if (!zyg || !pool) { perror("zygote"); return 1; }
+    }
 
     /* pipes kernel->IC */
     int p_ic[2];
     if (pipe(p_ic) < 0) { perror("pipe ic"); return 1; }
     fd_ic_r = p_ic[0];
     fd_ic_w = p_ic[1];
+    fcntl(fd_ic_w, F_SETFD, FD_CLOEXEC);
+
+    // Bloqueia os sinais tratados pelo kernel antes de qualquer fork, para
+    // que nenhum IRQ se perca; eles passam a ser lidos pelo signalfd.
+    // SA_NOCLDSTOP evita SIGCHLD a cada SIGSTOP/SIGCONT dos apps.
+    struct sigaction sa = {0};
+    sa.sa_handler = SIG_DFL;
+    sa.sa_flags = SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &sa, NULL);
+    sigset_t oldmask;
+    sigemptyset(&kmask);
+    sigaddset(&kmask, SIGUSR1); // IRQ0
+    sigaddset(&kmask, SIGUSR2); // IRQ1
+    sigaddset(&kmask, SIGALRM); // “acorda kernel”
+#ifdef SYS_pidfd_open
+    int self = (int)syscall(SYS_pidfd_open, getpid(), 0);
+    if (self >= 0) { use_pidfd = 1; close(self); }
+#endif
+    if (!use_pidfd) sigaddset(&kmask, SIGCHLD); // término de apps (sem pidfd)
+    sigprocmask(SIG_BLOCK, &kmask, &oldmask);
+    app_mask = oldmask;
+    posix_spawnattr_init(&spawn_attr);
+    posix_spawnattr_setsigmask(&spawn_attr, &app_mask);
+    posix_spawnattr_setflags(&spawn_attr, POSIX_SPAWN_SETSIGMASK);
+    trace_start();
+
+    /* fila de conclusões IC->kernel */
+    cq = cq_create(1024, &cq_fd);
+    if (!cq) { perror("cq"); return 1; }
 
     /* Fork InterController */
     ic_pid = fork();
     if (ic_pid == 0)
     {
+        sigprocmask(SIG_SETMASK, &oldmask, NULL);
         // O IC só precisa ler do pipe (fd_ic_r) e conhecer o PID do kernel
         close(fd_app_r);
         close(fd_app_w);
         close(fd_ic_w); /* IC só lê */
-        char fd_read_str[32], kpid[32];
+        if (ring) { close(ring_fd); close(bell_fd); }
+        if (park) close(park_fd);
+        if (zyg) close(zyg_fd);
+        close(kaio_fd);
+        char fd_read_str[32], kpid[32], cqfd[32], qns[32];
         snprintf(fd_read_str, sizeof(fd_read_str), "%d", fd_ic_r);
         snprintf(kpid, sizeof(kpid), "%d", getppid());
-        execl("./inter_controller", "./inter_controller", fd_read_str, kpid, (char *)NULL);
+        snprintf(cqfd, sizeof(cqfd), "%d", cq_fd);
+        snprintf(qns, sizeof(qns), "%lld", tickless ? 0 : quantum_ns); // tickless: o kernel programa
+        execl("./inter_controller", "./inter_controller", fd_read_str, kpid, cqfd, qns, (char *)NULL);
         perror("exec inter_controller");
         _exit(1);
     }
     close(fd_ic_r); // kernel não lê do IC
+    close(cq_fd);   // o mapeamento continua válido
     
-    // Instala handlers: IRQ0 (SIGUSR1), IRQ1 (SIGUSR2) e "nudge" (SIGALRM)
-    // SIGCHLD chama on_child_exit para marcar FINISHED
-    /* Handlers */
-    struct sigaction sa = {0};
-    sa.sa_handler = on_irq0;  sigaction(SIGUSR1, &sa, NULL); // IRQ0
-    sa.sa_handler = on_irq1;  sigaction(SIGUSR2, &sa, NULL); // IRQ1
-    sa.sa_handler = on_sysc;  sigaction(SIGALRM, &sa, NULL); // “acorda kernel”
-    signal(SIGCHLD, (void (*)(int))on_child_exit);
+    // Registra no epoll o signalfd (IRQ0, IRQ1, SIGALRM; SIGCHLD sem pidfd)
+    // e o pipe de apps: é a única espera bloqueante do kernel
+    sfd = signalfd(-1, &kmask, SFD_NONBLOCK | SFD_CLOEXEC);
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (sfd < 0 || epfd < 0) { perror("signalfd/epoll"); return 1; }
+    struct epoll_event ev = {.events = EPOLLIN};
+    ev.data.fd = sfd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, sfd, &ev);
+    ev.data.fd = ring ? bell_fd : fd_app_r;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, ev.data.fd, &ev);
+
+    // Chegadas futuras (--workload): timerfd absoluto na mesma espera
+    arr_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (arr_fd < 0) { perror("timerfd"); return 1; }
+    ev.data.fd = arr_fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, arr_fd, &ev);
+
+    // Admissão em execução (--ctl): FIFO aberto para leitura e escrita,
+    // então não há EOF quando um cliente fecha
+    if (ctl_path) {
+        if (mkfifo(ctl_path, 0600) == 0) ctl_made = 1;
+        else if (errno != EEXIST) { perror(ctl_path); return 1; }
+        ctl_fd = open(ctl_path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (ctl_fd < 0) { perror(ctl_path); return 1; }
+        ev.data.fd = ctl_fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, ctl_fd, &ev);
+        ctl_open = 1;
+    }
+
+    // Reserva de zigotos cheia antes do boot: as chegadas contam a partir
+    // daqui, sem o custo de pré-criar a reserva
+    if (zyg) {
+        pool_fill(pool_target);
+        boot_ns = real_ns();
+    }
 
-    // Cria e registra os apps A1..An (PCB + fila de PRONTOS)
+    tick_next = now_ns() + quantum_ns; // primeiro tick da grade (--tickless)
+    kcpu_boot_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
     log_ts_prefix();
-    printf(C_SCH "BOOT      ~~ KernelSim iniciando (%d apps)" C_RST "\n", nprocs);
-    for (int i = 0; i < nprocs; i++)
-    {
-        pid_t pid = fork();
-        if (pid == 0)
-        {
-            close(fd_app_r); /* app não lê */
-            close(fd_ic_r);
-            close(fd_ic_w);
-            char fdw[32], name[32], idx[8], kpid[32];
-            snprintf(fdw, sizeof(fdw), "%d", fd_app_w);
-            snprintf(idx, sizeof(idx), "%d", i + 1);
-            snprintf(name, sizeof(name), "A%d", i + 1);
-            snprintf(kpid, sizeof(kpid), "%d", getppid());
-            execl("./app", "./app", fdw, name, idx, kpid, (char *)NULL);
-            perror("exec app");
-            _exit(1);
-        }
-        else if (pid > 0)
-        {
-            snprintf(procs[i].name, sizeof(procs[i].name), "A%d", i + 1);
-            procs[i].pid = pid;
-            procs[i].st = ST_READY;
-            procs[i].last_pc = 0;
-            procs[i].last_syscall = -1;   /* parâmetro de syscall salvo no contexto */
-            rq_push(pid);
+    printf(C_SCH "BOOT      ~~ KernelSim iniciando (%d apps, política %s%s, %d CPU%s%s%s%s)" C_RST "\n",
+           napps, sched->name, adaptive ? " adaptativa" : "", ncpus, ncpus > 1 ? "s" : "", park ? ", portões" : "",
+           spawn_mode != SP_FORK ? ", spawn " : "", spawn_mode != SP_FORK ? spawn_names[spawn_mode] : "");
+    if (work_mode != WORK_SLEEP) {
+        log_ts_prefix();
+        printf(C_SCH "WORK      ~~ PC = %lld iterações de %s (%.3f ms de CPU, calibrado)" C_RST "\n",
+               work_iters, work_names[work_mode], work_ns / 1e6);
+    }
 
-            /* Congela imediatamente cada filho recém-criado
-               para não haver “PC ::” antes do primeiro DISPATCH */
-            kill(pid, SIGSTOP);
+    // Criação (SPAWN) de cada app no seu instante: os do boot agora, os
+    // demais no timerfd
+    admit_arrivals();
 
-            log_ts_prefix();
-            printf(C_APP "SPAWN     ++ %-3s (pid=%d) adicionado à fila de prontos" C_RST "\n",
-                   procs[i].name, (int)pid);
-        }
-        else
-        {
-            perror("fork app");
-            return 1;
-        }
-        // (sem sleep para reduzir janelas de corrida no boot)
-    }
+    // filas prontas; ninguém rodando ainda
 
-    current = -1;           // fila pronta; ninguém rodando ainda
-    
     // Dá o primeiro DISPATCH e entra no loop de escalonamento principal
-    dispatch_next();
+    dispatch_idle();
     schedule_loop();        
+    trace_stop();
+    if (ctl_made) unlink(ctl_path);
 
     // Encerramento ordenado: todos os apps e o IC concluídos
     log_ts_prefix();
@@ -0,0 +1,169 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+// Mostra o retrato ao vivo de um kernel_sim rodando com --stats F.
+// Uso: ./kstat [--watch S] [--count N] [--all] <arquivo>
+//   --watch  redesenha a cada S segundos (taxas no intervalo) até o kernel
+//            terminar; sem --watch, imprime um retrato (taxas médias)
+//   --count  com --watch, para depois de N retratos
+//   --all    inclui os processos já finalizados
+//
+// A leitura não interfere no kernel: a página é mapeada só para leitura
+// e o seqlock de kstat.h garante um retrato consistente (ver kstat.h).
+
+#include "common.h"
+#include "kstat.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <getopt.h>
+#include <poll.h>
+#include <sys/syscall.h>
+
+static const char *const st_names[] = {"PRONTO", "RODANDO", "BLOQ", "FIM"};
+
+static long long mono_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_pid(const void *a, const void *b)
+{
+    return ((const ks_proc_t *)a)->pid - ((const ks_proc_t *)b)->pid;
+}
+
+// Nome do processo pid no retrato (ordenado por PID), "-" se nenhum
+static const char *name_of(const kstat_t *k, int32_t pid)
+{
+    ks_proc_t key = {.pid = pid};
+    const ks_proc_t *p = pid >= 0 ? bsearch(&key, k->procs, (size_t)k->nprocs, sizeof(ks_proc_t), cmp_pid) : NULL;
+    return p ? p->name : pid >= 0 ? "?" : "-";
+}
+
+// Taxa por segundo de um contador entre dois retratos (ou desde o boot)
+static double rate(long long now, long long before, double dt)
+{
+    return dt > 0 ? (now - before) / dt : 0;
+}
+
+// Imprime o retrato k; prev (ordenado por PID) é o anterior, ou NULL
+static void show(const char *path, const kstat_t *k, const kstat_t *prev, int all)
+{
+    const kstat_t z = {0};
+    const kstat_t *b = prev ? prev : &z;
+    double dt = (k->now_ns - b->now_ns) / 1e9;
+    double age = (mono_ns() - k->real_ns) / 1e6;
+    printf("%s — kernel %d (%s, %d CPU%s, %d dispositivo%s%s), t=%.2fs, %s\n",
+           path, k->kernel_pid, k->policy, k->ncpus, k->ncpus > 1 ? "s" : "",
+           k->ndevs, k->ndevs > 1 ? "s" : "", k->des ? ", DES" : "", k->now_ns / 1e9,
+           k->done ? "terminou" : "ao vivo");
+    printf("retrato de %.0f ms atrás; taxas %s\n", age, prev ? "no intervalo" : "médias desde o boot");
+    printf("apps: %d admitidos, %d finalizados, %d prontos, %d pedidos de I/O pendentes\n",
+           k->total, k->finished, k->ready, k->io_pending);
+    printf("trocas %lld (%.1f/s) | preempções %lld (%.1f/s) | IRQ0 %lld (%.1f/s) | I/O %lld (%.1f/s) | %s %lld\n",
+           (long long)k->nswitch, rate(k->nswitch, b->nswitch, dt),
+           (long long)k->npreempt, rate(k->npreempt, b->npreempt, dt),
+           (long long)k->tick_irqs, rate(k->tick_irqs, b->tick_irqs, dt),
+           (long long)k->io_done, rate(k->io_done, b->io_done, dt),
+           k->des ? "eventos" : "rodadas", (long long)(k->des ? k->des_events : k->loop_rounds));
+    for (int c = 0; c < k->ncpus; c++)
+        printf("CPU%-3d %-16s fila %-5d uso %5.1f%%\n", c + 1, name_of(k, k->cpus[c].current),
+               k->cpus[c].ready, 100 * rate(k->cpus[c].busy_ns, c < b->ncpus ? b->cpus[c].busy_ns : 0, dt) / 1e9);
+    for (int d = 0; d < k->ndevs; d++)
+        printf("D%-5d %-16s fila %-5d uso %5.1f%%  %d pedidos (%d juntados), %.2f MB/s\n", d + 1,
+               name_of(k, k->devs[d].serving), k->devs[d].queued,
+               100 * rate(k->devs[d].busy_ns, d < b->ndevs ? b->devs[d].busy_ns : 0, dt) / 1e9,
+               k->devs[d].nreq, k->devs[d].nmerged,
+               rate(k->devs[d].bytes, d < b->ndevs ? b->devs[d].bytes : 0, dt) / 1048576.0);
+    printf("%-16s %7s %-7s %4s %6s %7s %5s %4s %8s %8s %8s %5s\n",
+           "NOME", "PID", "ESTADO", "CPU", "PC", "PC/s", "I/O", "AIO", "CPU_s", "ESPERA_s", "BLOQ_s", "DISP");
+    int hidden = 0;
+    for (int i = 0; i < k->nprocs; i++) {
+        const ks_proc_t *p = &k->procs[i];
+        if (p->st == ST_FINISHED && !all) { hidden++; continue; }
+        const ks_proc_t *q = NULL;
+        if (prev) q = bsearch(p, prev->procs, (size_t)prev->nprocs, sizeof(ks_proc_t), cmp_pid);
+        printf("%-16s %7d %-7s %4d %6d %7.1f %5d %4d %8.2f %8.2f %8.2f %5d\n",
+               p->name, p->pid, st_names[p->st & 3], p->cpu + 1, p->last_pc,
+               rate(p->last_pc, q ? q->last_pc : 0, dt), p->nio, p->aio_inflight,
+               p->cpu_ns / 1e9, p->wait_ns / 1e9, p->blocked_ns / 1e9, p->ndispatch);
+    }
+    if (hidden) printf("(%d finalizados ocultos; --all mostra)\n", hidden);
+    if (k->nprocs < k->total) printf("(%d processos não couberam no retrato)\n", k->total - k->nprocs);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option lopts[] = {
+        {"watch", required_argument, NULL, 'w'},
+        {"count", required_argument, NULL, 'n'},
+        {"all", no_argument, NULL, 'a'},
+        {NULL, 0, NULL, 0},
+    };
+    double watch_s = 0;
+    long count = 0;
+    int all = 0, opt;
+    while ((opt = getopt_long(argc, argv, "", lopts, NULL)) != -1) {
+        if (opt == 'w' && (watch_s = atof(optarg)) > 0) continue;
+        if (opt == 'n' && (count = atol(optarg)) > 0) continue;
+        if (opt == 'a') { all = 1; continue; }
+        argc = 0;
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Uso: %s [--watch S] [--count N] [--all] <arquivo do --stats>\n", argv[0]);
+        return 1;
+    }
+    const char *path = argv[optind];
+    size_t bytes;
+    const kstat_t *k = ks_attach(path, &bytes);
+    if (!k) {
+        fprintf(stderr, "%s: não é um retrato do KernelSim (--stats) ou versão diferente\n", path);
+        return 1;
+    }
+
+    // dois buffers: o retrato atual e o anterior (taxas por processo)
+    kstat_t *cur = malloc(ks_bytes(k->cap)), *prev = malloc(ks_bytes(k->cap));
+    if (!cur || !prev) { perror("kstat"); return 1; }
+    ks_read(k, cur);
+    qsort(cur->procs, (size_t)cur->nprocs, sizeof(ks_proc_t), cmp_pid);
+    if (watch_s <= 0) {
+        show(path, cur, NULL, all);
+        return 0;
+    }
+
+    // pidfd do kernel: a espera entre retratos acorda se ele terminar
+    int kfd = -1;
+#ifdef SYS_pidfd_open
+    kfd = (int)syscall(SYS_pidfd_open, cur->kernel_pid, 0);
+#endif
+    int gone = kfd < 0 && kill(cur->kernel_pid, 0) < 0 && errno == ESRCH;
+    for (long shown = 1;; shown++) {
+        printf("\x1b[H\x1b[2J");
+        show(path, cur, shown > 1 ? prev : NULL, all);
+        fflush(stdout);
+        if (cur->done || (count && shown >= count)) break;
+        if (gone) {
+            printf("kernel %d não está mais rodando (retrato incompleto)\n", cur->kernel_pid);
+            return 1;
+        }
+        if (kfd >= 0) {
+            struct pollfd pf = {.fd = kfd, .events = POLLIN};
+            gone = poll(&pf, 1, (int)(watch_s * 1000)) > 0;
+        } else {
+            struct timespec nap = {(time_t)watch_s, (long)((watch_s - (time_t)watch_s) * 1e9)};
+            nanosleep(&nap, NULL);
+            gone = kill(cur->kernel_pid, 0) < 0 && errno == ESRCH;
+        }
+        kstat_t *t = prev;
+        prev = cur;
+        cur = t;
+        ks_read(k, cur);
+        qsort(cur->procs, (size_t)cur->nprocs, sizeof(ks_proc_t), cmp_pid);
+    }
+    return 0;
+}
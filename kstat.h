@@ -0,0 +1,159 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef KSTAT_H
+#define KSTAT_H
+
+/* Retrato ao vivo do kernel (--stats F), no espírito do /proc: uma página
+   em memória compartilhada (arquivo F, de preferência em /dev/shm) com o
+   estado de cada processo, das filas, dos núcleos e dos dispositivos e os
+   contadores globais. O kernel reescreve o retrato inteiro no máximo a
+   cada KS_PERIOD_NS, fora do caminho de escalonamento; o ./kstat lê.
+
+   Sincronização por seqlock: o kernel torna seq ímpar, escreve e torna
+   seq par de novo; o leitor copia o retrato e confere se seq não mudou
+   (nem estava ímpar) durante a cópia, senão copia de novo. O kernel
+   nunca espera por leitor, e leitores não escrevem na página (mapeada só
+   para leitura). Ao terminar, o kernel publica um último retrato com
+   done = 1 e deixa o arquivo. Header-only, usado por kernel_sim.c e
+   kstat.c. */
+
+#include "common.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define KS_MAGIC     "KSIMSTAT"
+#define KS_VERSION   2
+#define KS_PERIOD_NS 100000000LL   // intervalo mínimo entre publicações
+#define KS_MAX_CPUS  64            // núcleos e dispositivos além disso não aparecem
+#define KS_MAX_DEVS  64
+#define KS_SLACK     1024          // linhas além dos apps do boot (--ctl)
+
+typedef struct {
+    int32_t pid;
+    char    name[MAX_NAME];
+    int32_t st;            // pstate_t
+    int32_t cpu;           // núcleo (-1 = nenhum ainda)
+    int32_t last_pc;
+    int32_t io_dev;        // dispositivo da SYSCALL de I/O pendente, -1 = nenhum
+    int32_t aio_inflight;  // pedidos assíncronos em voo (kaio.h)
+    int32_t ndispatch, npreempt, nio;
+    int64_t cpu_ns, wait_ns, blocked_ns;
+} ks_proc_t;
+
+typedef struct {
+    int32_t current;       // PID em RUNNING, -1 = ocioso
+    int32_t ready;         // prontos na fila do núcleo
+    int64_t busy_ns;
+} ks_cpu_t;
+
+typedef struct {
+    int32_t queued;        // pedidos na fila
+    int32_t serving;       // PID em serviço, -1 = livre
+    int32_t nreq, nmerged;
+    int64_t bytes, busy_ns;
+} ks_dev_t;
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t cap;          // linhas em procs[]
+    _Atomic uint32_t seq;  // ímpar = kernel escrevendo
+    int32_t  kernel_pid;
+    int32_t  done;         // kernel terminou (último retrato)
+    int32_t  des;
+    char     policy[16];
+    int32_t  ncpus, ndevs; // linhas válidas em cpus[] e devs[]
+    int32_t  nprocs;       // linhas válidas em procs[]
+    int32_t  total;        // processos admitidos até agora
+    int32_t  finished, ready, io_pending;
+    int64_t  now_ns;       // relógio do kernel desde o boot (virtual no --des)
+    int64_t  real_ns;      // CLOCK_MONOTONIC da publicação (idade do retrato)
+    int64_t  nswitch, npreempt, tick_irqs, loop_rounds, des_events, io_done;
+    ks_cpu_t cpus[KS_MAX_CPUS];
+    ks_dev_t devs[KS_MAX_DEVS];
+    ks_proc_t procs[];
+} kstat_t;
+
+static inline size_t ks_bytes(uint32_t cap)
+{
+    return sizeof(kstat_t) + (size_t)cap * sizeof(ks_proc_t);
+}
+
+// Cria (ou recria) o arquivo com espaço para cap processos (kernel); NULL em erro
+static inline kstat_t *ks_create(const char *path, uint32_t cap)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, (off_t)ks_bytes(cap)) < 0) { close(fd); return NULL; }
+    kstat_t *k = mmap(NULL, ks_bytes(cap), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (k == MAP_FAILED) return NULL;
+    k->version = KS_VERSION;
+    k->cap = cap;
+    k->kernel_pid = (int32_t)getpid();
+    memcpy(k->magic, KS_MAGIC, 8);   // por último: página pronta
+    return k;
+}
+
+// Mapeia o retrato só para leitura (kstat); NULL se não é um retrato válido
+static inline const kstat_t *ks_attach(const char *path, size_t *bytes_out)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct stat st;
+    const kstat_t *k = NULL;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(kstat_t)) {
+        k = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (k == MAP_FAILED) k = NULL;
+    }
+    close(fd);
+    if (k && (memcmp(k->magic, KS_MAGIC, 8) != 0 || k->version != KS_VERSION
+              || ks_bytes(k->cap) > (size_t)st.st_size)) {
+        munmap((void *)k, (size_t)st.st_size);
+        return NULL;
+    }
+    *bytes_out = k ? (size_t)st.st_size : 0;
+    return k;
+}
+
+// Kernel: abre uma escrita (seq ímpar); os leitores vão repetir a cópia
+static inline void ks_write_begin(kstat_t *k)
+{
+    uint32_t s = atomic_load_explicit(&k->seq, memory_order_relaxed);
+    atomic_store_explicit(&k->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+// Kernel: fecha a escrita (seq par): retrato consistente
+static inline void ks_write_end(kstat_t *k)
+{
+    uint32_t s = atomic_load_explicit(&k->seq, memory_order_relaxed);
+    atomic_store_explicit(&k->seq, s + 1, memory_order_release);
+}
+
+// Leitor: copia um retrato consistente para out (com espaço para k->cap
+// linhas); devolve quantas tentativas foram necessárias
+static inline int ks_read(const kstat_t *k, kstat_t *out)
+{
+    for (int tries = 1;; tries++) {
+        uint32_t s1 = atomic_load_explicit(&k->seq, memory_order_acquire);
+        if (s1 & 1) { sched_yield(); continue; }
+        memcpy(out, k, sizeof(kstat_t));
+        uint32_t n = (uint32_t)out->nprocs <= k->cap ? (uint32_t)out->nprocs : 0;
+        memcpy(out->procs, k->procs, (size_t)n * sizeof(ks_proc_t));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&k->seq, memory_order_relaxed) == s1) {
+            out->nprocs = (int32_t)n;
+            return tries;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+// Reconstrói o log do kernel a partir de um trace binário (--trace).
+// Uso: ./ktrace [--plain] [--chrome <saida.json>] <arquivo>
+//   --plain   sem códigos de cor ANSI
+//   --chrome  converte para a linha do tempo do Chrome/Perfetto (chrome.h)
+
+#include "common.h"
+#include "ptable.h"
+#include "trace.h"
+#include "chrome.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+// Copia `s` para `f` sem as sequências ESC[...m
+static void put_plain(FILE *f, const char *s)
+{
+    while (*s) {
+        if (*s == '\x1b') {
+            while (*s && *s != 'm') s++;
+            if (*s) s++;
+            continue;
+        }
+        fputc(*s++, f);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option lopts[] = {
+        {"plain", no_argument, NULL, 'p'},
+        {"chrome", required_argument, NULL, 'c'},
+        {NULL, 0, NULL, 0},
+    };
+    int opt, plain = 0;
+    const char *chrome_path = NULL;
+    while ((opt = getopt_long(argc, argv, "", lopts, NULL)) != -1) {
+        if (opt == 'p') plain = 1;
+        else if (opt == 'c') chrome_path = optarg;
+        else argc = 0;
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Uso: %s [--plain] [--chrome <saida.json>] <arquivo de trace>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[optind], "rb");
+    if (!in) { perror(argv[optind]); return 1; }
+    trace_hdr_t h;
+    if (fread(&h, sizeof(h), 1, in) != 1 || memcmp(h.magic, TRACE_MAGIC, 8) != 0
+        || h.rec_size != sizeof(trace_rec_t)) {
+        fprintf(stderr, "%s: não é um trace do KernelSim (ou versão diferente)\n", argv[optind]);
+        return 1;
+    }
+
+    chrome_t ch = {0};
+    if (chrome_path && !chrome_open(&ch, chrome_path)) { perror(chrome_path); return 1; }
+
+    // PID -> nome, aprendido nos registros SPAWN
+    ptable_t names;
+    pt_init(&names, 64);
+
+    char line[512];
+    trace_rec_t r[256];
+    size_t n;
+    unsigned long long total = 0;
+    while ((n = fread(r, sizeof(trace_rec_t), 256, in)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            pcb_t *p = pt_get(&names, r[i].pid);
+            if (r[i].type == TR_SPAWN) {
+                if (!p) p = pt_add(&names, r[i].pid);
+                memcpy(p->name, &r[i].x, MAX_NAME);
+                p->name[MAX_NAME - 1] = '\0';
+            }
+            const char *name = p ? p->name : "?";
+            if (ch.f) {
+                chrome_event(&ch, &r[i], name);
+                continue;
+            }
+            if (!plain) {
+                trace_render(stdout, &h, &r[i], name);
+                continue;
+            }
+            FILE *mf = fmemopen(line, sizeof(line), "w");
+            if (!mf) { perror("fmemopen"); return 1; }
+            trace_render(mf, &h, &r[i], name);
+            fclose(mf);
+            put_plain(stdout, line);
+        }
+        total += n;
+    }
+    fclose(in);
+    if (ch.f) chrome_close(&ch);
+    fprintf(stderr, "# %llu eventos, política %s, %d CPU%s%s, %llu descartados\n",
+            total, h.policy, h.ncpus, h.ncpus > 1 ? "s" : "", h.des ? ", DES" : "",
+            (unsigned long long)h.dropped);
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef MSGRING_H
+#define MSGRING_H
+
+/* Transporte app->kernel em memória compartilhada (alternativa ao pipe).
+   Anel limitado de appmsg_t, vários produtores (apps) e um consumidor
+   (kernel), sem locks: cada slot tem um número de sequência (esquema de
+   Vyukov); o produtor reserva a posição com CAS em `tail` e publica o
+   slot com store-release de `seq`.
+
+   Campainha: o kernel marca `sleeping` antes de bloquear no epoll. Quem
+   publica e encontra `sleeping` ligado troca para 0 e escreve 1 no
+   eventfd — só um produtor toca, e só quando o kernel está dormindo.
+   Com o kernel acordado, um STATUS custa zero syscalls.
+
+   O anel vive num memfd herdado pelos apps no exec (fd passado em argv).
+   Header-only, usado por kernel_sim.c, app.c e bench.c. */
+
+#include "common.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+typedef struct {
+    _Atomic uint32_t seq;
+    appmsg_t m;
+} msgslot_t;
+
+typedef struct {
+    _Atomic uint32_t sleeping;   // 1 = kernel dormindo; produtor deve tocar
+    uint32_t mask;               // capacidade-1 (potência de 2)
+    char _pad0[56];
+    _Atomic uint32_t tail;       // próxima posição a reservar (produtores)
+    char _pad1[60];
+    uint32_t head;               // próxima posição a consumir (kernel)
+    char _pad2[60];
+    msgslot_t slots[];
+} msgring_t;
+
+static inline size_t msgring_bytes(uint32_t cap)
+{
+    return sizeof(msgring_t) + (size_t)cap * sizeof(msgslot_t);
+}
+
+// Cria o anel num memfd (kernel). cap é arredondada para potência de 2.
+// Retorna o mapeamento e o fd em *fd_out; NULL em erro.
+static inline msgring_t *msgring_create(uint32_t cap, int *fd_out)
+{
+    uint32_t c = 64;
+    while (c < cap) c <<= 1;
+    int fd = memfd_create("ksim-msgring", 0);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, (off_t)msgring_bytes(c)) < 0) { close(fd); return NULL; }
+    msgring_t *r = mmap(NULL, msgring_bytes(c), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (r == MAP_FAILED) { close(fd); return NULL; }
+    r->mask = c - 1;
+    for (uint32_t i = 0; i < c; i++) atomic_store(&r->slots[i].seq, i);
+    *fd_out = fd;
+    return r;
+}
+
+// Mapeia um anel já criado (apps, a partir do fd herdado)
+static inline msgring_t *msgring_attach(int fd)
+{
+    msgring_t *hdr = mmap(NULL, sizeof(msgring_t), PROT_READ, MAP_SHARED, fd, 0);
+    if (hdr == MAP_FAILED) return NULL;
+    uint32_t cap = hdr->mask + 1;
+    munmap(hdr, sizeof(msgring_t));
+    msgring_t *r = mmap(NULL, msgring_bytes(cap), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return r == MAP_FAILED ? NULL : r;
+}
+
+// Tenta publicar; 0 se o anel está cheio
+static inline int msgring_try_push(msgring_t *r, const appmsg_t *m)
+{
+    uint32_t pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    for (;;) {
+        msgslot_t *s = &r->slots[pos & r->mask];
+        uint32_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        int32_t dif = (int32_t)(seq - pos);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                s->m = *m;
+                atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+                return 1;
+            }
+        } else if (dif < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        }
+    }
+}
+
+// Toca a campainha se o kernel está dormindo; retorna 1 se tocou
+static inline int msgring_ring_bell(msgring_t *r, int efd)
+{
+    if (atomic_load(&r->sleeping) && atomic_exchange(&r->sleeping, 0)) {
+        uint64_t one = 1;
+        (void)write(efd, &one, sizeof(one));
+        return 1;
+    }
+    return 0;
+}
+
+// Publica (esperando vaga se cheio) e acorda o kernel se preciso
+static inline void msgring_push(msgring_t *r, int efd, const appmsg_t *m)
+{
+    while (!msgring_try_push(r, m)) {
+        msgring_ring_bell(r, efd); // kernel precisa drenar
+        sched_yield();
+    }
+    msgring_ring_bell(r, efd);
+}
+
+// Consome uma mensagem (só o kernel); 0 se vazio
+static inline int msgring_pop(msgring_t *r, appmsg_t *out)
+{
+    msgslot_t *s = &r->slots[r->head & r->mask];
+    uint32_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+    if (seq != r->head + 1) return 0;
+    *out = s->m;
+    atomic_store_explicit(&s->seq, r->head + r->mask + 1, memory_order_release);
+    r->head++;
+    return 1;
+}
+
+// Kernel vai dormir: liga `sleeping` e confere se algo chegou no meio.
+// Retorna 0 (e desliga o flag) se há mensagem pendente: não durma.
+static inline int msgring_prepare_sleep(msgring_t *r)
+{
+    atomic_store(&r->sleeping, 1);
+    msgslot_t *s = &r->slots[r->head & r->mask];
+    if (atomic_load(&s->seq) == r->head + 1) {
+        atomic_store(&r->sleeping, 0);
+        return 0;
+    }
+    return 1;
+}
+
+#endif
@@ -0,0 +1,95 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef PARK_H
+#define PARK_H
+
+/* Troca de contexto por estacionamento (--switch park), alternativa ao
+   par SIGSTOP/SIGCONT. Cada app tem uma palavra `gate` numa área
+   compartilhada (memfd herdado no exec), uma por linha de cache:
+     PARK_STOP  o kernel mandou parar (ou o app parou sozinho no I/O)
+     PARK_WAIT  parado e dormindo no futex: quem liberar precisa acordar
+     PARK_RUN   liberado pelo kernel
+
+   Parar custa um CAS, sem syscall: o app obedece no próximo ponto de
+   parada (antes de reportar um PC e ao terminar de consumi-lo). Como o
+   prazo do PC é absoluto (work_until em app.c), parar ali ou no meio do
+   PC dá o mesmo resultado visível. Retomar custa uma troca atômica e só
+   faz futex(WAKE) se o app já estiver dormindo.
+
+   Não há sinal a perder: um CONT antes do app dormir apenas faz o
+   futex(WAIT) voltar na hora (EAGAIN), então o kernel não precisa do
+   reforço de SIGCONT a cada IRQ0. Header-only, usado por kernel_sim.c,
+   app.c e bench.c. */
+
+#include "common.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+enum { PARK_STOP = 0, PARK_WAIT = 1, PARK_RUN = 2 };
+
+typedef struct {
+    _Atomic uint32_t gate;
+    char _pad[60];
+} parkslot_t;
+
+// Sem FUTEX_PRIVATE_FLAG: a palavra é compartilhada entre processos
+static inline void park_futex(_Atomic uint32_t *w, int op, uint32_t val)
+{
+    syscall(SYS_futex, (uint32_t *)w, op, val, NULL, NULL, 0);
+}
+
+// Cria a área com n portões, todos parados (kernel); NULL em erro
+static inline parkslot_t *park_create(int n, int *fd_out)
+{
+    size_t bytes = (size_t)n * sizeof(parkslot_t);
+    int fd = memfd_create("ksim-park", 0);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, (off_t)bytes) < 0) { close(fd); return NULL; }
+    parkslot_t *v = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (v == MAP_FAILED) { close(fd); return NULL; }
+    for (int i = 0; i < n; i++) atomic_store(&v[i].gate, PARK_STOP);
+    *fd_out = fd;
+    return v;
+}
+
+// Mapeia a área herdada e devolve o portão `slot` (apps)
+static inline _Atomic uint32_t *park_attach(int fd, int slot)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < (size_t)(slot + 1) * sizeof(parkslot_t))
+        return NULL;
+    parkslot_t *v = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return v == MAP_FAILED ? NULL : &v[slot].gate;
+}
+
+// Kernel: pede a parada (se já parado, nada muda)
+static inline void park_stop(_Atomic uint32_t *g)
+{
+    uint32_t run = PARK_RUN;
+    atomic_compare_exchange_strong(g, &run, PARK_STOP);
+}
+
+// Kernel: libera; acorda só quem está dormindo no futex
+static inline void park_cont(_Atomic uint32_t *g)
+{
+    if (atomic_exchange(g, PARK_RUN) == PARK_WAIT) park_futex(g, FUTEX_WAKE, 1);
+}
+
+// App: ponto de parada; dorme enquanto o kernel não liberar
+static inline void park_point(_Atomic uint32_t *g)
+{
+    for (;;) {
+        uint32_t v = atomic_load(g);
+        if (v == PARK_RUN) return;
+        if (v == PARK_STOP && !atomic_compare_exchange_strong(g, &v, PARK_WAIT)) continue;
+        park_futex(g, FUTEX_WAIT, PARK_WAIT);
+    }
+}
+
+#endif
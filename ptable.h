@@ -0,0 +1,140 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef PTABLE_H
+#define PTABLE_H
+
+/* Tabela de processos dinâmica (PCBs) com:
+   - índice PID -> PCB por hash aberto (busca O(1))
+   - filas intrusivas: cada PCB guarda os links da fila onde está,
+     então push, pop e remoção de um PID qualquer são O(1).
+   Header-only (static) para que cada programa continue sendo um único
+   .c compilado sozinho. Ponteiros para PCB podem mudar em pt_add()
+   (realloc): guarde PIDs ou índices entre inserções, não ponteiros. */
+
+#include "common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Fila intrusiva: head/tail são índices em ptable_t.v (-1 = vazia) */
+typedef struct pqueue {
+    int head, tail;
+    int count;
+} pqueue_t;
+
+typedef struct {
+    pcb_t *v;        // PCBs, na ordem de criação
+    int    n, cap;
+    int   *hidx;     // hash PID -> índice+1 (0 = slot vazio)
+    int    hcap;     // potência de 2
+} ptable_t;
+
+static inline unsigned pt_hash(pid_t pid, int hcap)
+{
+    return ((unsigned)pid * 2654435761u) & (unsigned)(hcap - 1);
+}
+
+// Aponta o PID para o índice i. PID já presente: é um processo que
+// terminou e foi colhido, e o PID voltou num processo novo; a entrada
+// passa ao novo PCB (o antigo fica na tabela só para o relatório)
+static inline void pt_hash_put(ptable_t *t, pid_t pid, int i)
+{
+    unsigned h = pt_hash(pid, t->hcap);
+    while (t->hidx[h] && t->v[t->hidx[h] - 1].pid != pid) h = (h + 1) & (unsigned)(t->hcap - 1);
+    t->hidx[h] = i + 1;
+}
+
+static inline void pt_init(ptable_t *t, int cap)
+{
+    memset(t, 0, sizeof(*t));
+    t->cap = cap < 4 ? 4 : cap;
+    t->v = calloc((size_t)t->cap, sizeof(pcb_t));
+    t->hcap = 16;
+    while (t->hcap < 2 * t->cap) t->hcap <<= 1;
+    t->hidx = calloc((size_t)t->hcap, sizeof(int));
+    if (!t->v || !t->hidx) { perror("ptable"); exit(1); }
+}
+
+// Acrescenta um PCB zerado para `pid` (dobra a tabela se preciso)
+static inline pcb_t *pt_add(ptable_t *t, pid_t pid)
+{
+    if (t->n == t->cap) {
+        t->cap *= 2;
+        t->v = realloc(t->v, (size_t)t->cap * sizeof(pcb_t));
+        if (!t->v) { perror("ptable"); exit(1); }
+    }
+    if (2 * (t->n + 1) > t->hcap) {
+        free(t->hidx);
+        t->hcap <<= 1;
+        t->hidx = calloc((size_t)t->hcap, sizeof(int));
+        if (!t->hidx) { perror("ptable"); exit(1); }
+        for (int i = 0; i < t->n; i++) pt_hash_put(t, t->v[i].pid, i);   // o mais novo fica
+    }
+    int i = t->n++;
+    pcb_t *p = &t->v[i];
+    memset(p, 0, sizeof(*p));
+    p->pid = pid;
+    p->idx = i;
+    p->q = NULL;
+    p->q_next = p->q_prev = -1;
+    pt_hash_put(t, pid, i);
+    return p;
+}
+
+// Busca o PCB pelo PID (o mais novo, se o PID foi reusado); NULL se não existe
+static inline pcb_t *pt_get(const ptable_t *t, pid_t pid)
+{
+    if (t->hcap == 0) return NULL;
+    unsigned h = pt_hash(pid, t->hcap);
+    int i;
+    while ((i = t->hidx[h]) != 0) {
+        if (t->v[i - 1].pid == pid) return &t->v[i - 1];
+        h = (h + 1) & (unsigned)(t->hcap - 1);
+    }
+    return NULL;
+}
+
+/* ====== Filas intrusivas ====== */
+static inline void pq_init(pqueue_t *q)
+{
+    q->head = q->tail = -1;
+    q->count = 0;
+}
+
+// Insere no fim; um PCB está em no máximo uma fila por vez
+static inline void pq_push(ptable_t *t, pqueue_t *q, pcb_t *p)
+{
+    if (p->q) return;
+    p->q = q;
+    p->q_next = -1;
+    p->q_prev = q->tail;
+    if (q->tail >= 0) t->v[q->tail].q_next = p->idx;
+    else q->head = p->idx;
+    q->tail = p->idx;
+    q->count++;
+}
+
+// Retira o PCB da fila em que estiver (no-op se não está em fila)
+static inline void pq_remove(ptable_t *t, pcb_t *p)
+{
+    pqueue_t *q = p->q;
+    if (!q) return;
+    if (p->q_prev >= 0) t->v[p->q_prev].q_next = p->q_next;
+    else q->head = p->q_next;
+    if (p->q_next >= 0) t->v[p->q_next].q_prev = p->q_prev;
+    else q->tail = p->q_prev;
+    p->q = NULL;
+    p->q_next = p->q_prev = -1;
+    q->count--;
+}
+
+static inline pcb_t *pq_pop(ptable_t *t, pqueue_t *q)
+{
+    if (q->head < 0) return NULL;
+    pcb_t *p = &t->v[q->head];
+    pq_remove(t, p);
+    return p;
+}
+
+#endif
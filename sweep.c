@@ -0,0 +1,417 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+// Varredura de parâmetros: roda o ./kernel_sim em todas as combinações de
+// uma grade, várias simulações ao mesmo tempo, e junta as métricas de cada
+// uma (--report-json) numa tabela CSV na saída padrão.
+// Uso: ./sweep [-j N] [--policy rr,mlfq] [--quantum-ms 100,500]
+//              [--devices 1,2] [--cpus 1,2] [--workload a.txt,b.txt]
+//              [--apps 3,6] [--disk-sched fifo,clook] [--repeat R]
+//              [--timeout S] [--keep DIR]
+//              [-- <opções do kernel_sim>] > resultados.csv
+//   -j         simulações simultâneas (padrão: núcleos da máquina)
+//   --apps     num_apps do kernel_sim (com --workload: os primeiros N)
+//   --repeat   repete cada combinação R vezes (o modo real varia entre execuções)
+//   --timeout  mata a simulação que passar de S segundos (0 = sem limite)
+//   --keep     guarda o log e o JSON de cada execução em DIR
+// Exemplo: ./sweep --policy rr,mlfq,cfs --quantum-ms 50,100,200,500
+//                  --workload carga.txt -- --des
+//
+// Cada simulação roda no seu próprio grupo de processos (kernel, IC e
+// apps), e o kernel_sim só usa pipes, memfds e sinais entre os processos
+// que ele mesmo criou: instâncias simultâneas não se enxergam. Por isso
+// não se repassa o que tem nome no sistema de arquivos: --ctl (FIFO),
+// --stats (página compartilhada: as execuções escreveriam todas no mesmo
+// retrato) e as saídas em arquivo (--report-*, --trace, --chrome), que o
+// sweep controla.
+
+#include "common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define MAX_VALS 64
+
+// Uma dimensão da grade: valores separados por vírgula
+typedef struct {
+    const char *opt;        // opção do kernel_sim (NULL = num_apps, posicional)
+    const char *col;        // coluna no CSV
+    char *v[MAX_VALS];
+    int   n;                // 0 = não varia (padrão do kernel_sim)
+} axis_t;
+
+enum { AX_WORKLOAD, AX_APPS, AX_POLICY, AX_CPUS, AX_DEVICES, AX_QUANTUM, AX_DISK, AX_N };
+static axis_t axes[AX_N] = {
+    [AX_WORKLOAD] = {"--workload", "workload"},
+    [AX_APPS]     = {NULL, "apps"},
+    [AX_POLICY]   = {"--policy", "policy"},
+    [AX_CPUS]     = {"--cpus", "cpus"},
+    [AX_DEVICES]  = {"--devices", "devices"},
+    [AX_QUANTUM]  = {"--quantum-ms", "quantum_ms"},
+    [AX_DISK]     = {"--disk-sched", "disk_sched"},
+};
+
+// Uma execução: combinação da grade e o resumo do seu --report-json
+typedef struct {
+    int    sel[AX_N];       // índice do valor em cada dimensão
+    int    rep;
+    pid_t  pid;
+    long long t0_ns, wall_ns;
+    int    status;          // 0 = ok; >0 código de saída; <0 sinal
+    int    timed_out;
+    int    have;            // resumo lido do JSON
+    double span, util, ta_mean, ta_p50, ta_p99, wt_p50, wt_p99, rt_p50, rt_p99;
+    double io_p50, io_p99, io_mb_s;
+    long   nswitch, npreempt;
+} run_t;
+
+static char **extra = NULL;   // opções repassadas ao kernel_sim
+static int nextra = 0;
+static char dir[256];
+static int keep = 0;
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Uso: %s [-j N] [--policy P,..] [--quantum-ms Q,..] [--devices N,..] [--cpus N,..]\n"
+            "          [--workload F,..] [--apps N,..] [--disk-sched S,..] [--repeat R]\n"
+            "          [--timeout S] [--keep DIR]\n"
+            "          [-- <opções do kernel_sim>]\n", argv0);
+    exit(1);
+}
+
+static void axis_parse(axis_t *a, char *list)
+{
+    a->n = 0;
+    char *save = NULL;
+    for (char *t = strtok_r(list, ",", &save); t; t = strtok_r(NULL, ",", &save)) {
+        if (a->n == MAX_VALS) {
+            fprintf(stderr, "sweep: no máximo %d valores em --%s\n", MAX_VALS, a->col);
+            exit(1);
+        }
+        a->v[a->n++] = t;
+    }
+}
+
+// Valor da dimensão k na execução r ("" se a dimensão não varia)
+static const char *axis_val(const run_t *r, int k)
+{
+    return axes[k].n ? axes[k].v[r->sel[k]] : "";
+}
+
+// Caminho do log ou do JSON da execução i
+static void run_path(char *out, size_t len, int i, const char *ext)
+{
+    snprintf(out, len, "%s/run-%04d.%s", dir, i, ext);
+}
+
+// Descrição curta da combinação (progresso em stderr)
+static void run_desc(const run_t *r, char *out, size_t len)
+{
+    size_t o = 0;
+    out[0] = '\0';
+    for (int k = 0; k < AX_N && o < len; k++)
+        if (axes[k].n > 1)
+            o += (size_t)snprintf(out + o, len - o, "%s%s=%s", o ? " " : "", axes[k].col, axis_val(r, k));
+    if (o == 0) snprintf(out, len, "(única combinação)");
+}
+
+// Cria a simulação da execução i no seu próprio grupo de processos. A
+// saída vai para o log só com --keep; stderr sempre (mostra o erro de uma
+// execução que falhou).
+static void run_start(run_t *r, int i, const sigset_t *oldmask)
+{
+    char json[320], log[320];
+    run_path(json, sizeof(json), i, "json");
+    run_path(log, sizeof(log), i, "log");
+
+    char **av = calloc((size_t)nextra + 2 * AX_N + 4, sizeof(char *));
+    if (!av) { perror("sweep"); exit(1); }
+    int ac = 0;
+    av[ac++] = "./kernel_sim";
+    for (int k = 0; k < AX_N; k++)
+        if (axes[k].n && axes[k].opt) {
+            av[ac++] = (char *)axes[k].opt;
+            av[ac++] = axes[k].v[r->sel[k]];
+        }
+    for (int k = 0; k < nextra; k++) av[ac++] = extra[k];
+    av[ac++] = "--report-json";
+    av[ac++] = json;
+    if (axes[AX_APPS].n) av[ac++] = axes[AX_APPS].v[r->sel[AX_APPS]];
+    av[ac] = NULL;
+
+    r->t0_ns = now_ns();
+    r->pid = fork();
+    if (r->pid == 0) {
+        setpgid(0, 0);
+        sigprocmask(SIG_SETMASK, oldmask, NULL);
+        int out = open(keep ? log : "/dev/null", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int err = keep ? out : open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out >= 0) dup2(out, 1);
+        if (err >= 0) dup2(err, 2);
+        execv(av[0], av);
+        perror("exec ./kernel_sim");
+        _exit(127);
+    }
+    if (r->pid < 0) { perror("fork"); exit(1); }
+    setpgid(r->pid, r->pid); // o filho também faz: sem corrida com o kill do grupo
+    free(av);
+}
+
+// Número depois de "chave": a partir de s; 0 se ausente
+static int json_num(const char *s, const char *key, double *out)
+{
+    char pat[64];
+    snprintf(pat, sizeof(pat), "\"%s\":", key);
+    const char *p = s ? strstr(s, pat) : NULL;
+    if (!p) return 0;
+    *out = strtod(p + strlen(pat), NULL);
+    return 1;
+}
+
+// Lê o resumo do --report-json (config e summary ficam no começo do arquivo)
+static void run_read(run_t *r, int i)
+{
+    char path[320], buf[8192];
+    run_path(path, sizeof(path), i, "json");
+    FILE *f = fopen(path, "r");
+    if (!f) return;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    const char *ta = strstr(buf, "\"turnaround_s\"");
+    const char *wt = strstr(buf, "\"waiting_s\"");
+    const char *rt = strstr(buf, "\"response_s\"");
+    double sw = 0, pr = 0;
+    r->have = json_num(buf, "span_s", &r->span) && json_num(buf, "cpu_util", &r->util)
+              && json_num(buf, "context_switches", &sw) && json_num(buf, "preemptions", &pr)
+              && json_num(ta, "mean", &r->ta_mean) && json_num(ta, "p50", &r->ta_p50)
+              && json_num(ta, "p99", &r->ta_p99) && json_num(wt, "p50", &r->wt_p50)
+              && json_num(wt, "p99", &r->wt_p99) && json_num(rt, "p50", &r->rt_p50)
+              && json_num(rt, "p99", &r->rt_p99) && json_num(buf, "io_lat_p50_s", &r->io_p50)
+              && json_num(buf, "io_lat_p99_s", &r->io_p99) && json_num(buf, "io_mb_s", &r->io_mb_s);
+    r->nswitch = (long)sw;
+    r->npreempt = (long)pr;
+}
+
+// Remove os arquivos de uma execução que deu certo (sem --keep)
+static void run_clean(int i)
+{
+    char path[320];
+    run_path(path, sizeof(path), i, "json");
+    unlink(path);
+    run_path(path, sizeof(path), i, "log");
+    unlink(path);
+}
+
+static void print_csv(const run_t *runs, int total)
+{
+    printf("run");
+    for (int k = 0; k < AX_N; k++) printf(",%s", axes[k].col);
+    printf(",rep,status,wall_s,span_s,cpu_util,context_switches,preemptions,"
+           "turnaround_mean_s,turnaround_p50_s,turnaround_p99_s,wait_p50_s,wait_p99_s,"
+           "response_p50_s,response_p99_s,io_lat_p50_s,io_lat_p99_s,io_mb_s\n");
+    for (int i = 0; i < total; i++) {
+        const run_t *r = &runs[i];
+        printf("%d", i + 1);
+        for (int k = 0; k < AX_N; k++) printf(",%s", axis_val(r, k));
+        if (r->timed_out) printf(",%d,timeout", r->rep + 1);
+        else if (r->status) printf(",%d,%s%d", r->rep + 1, r->status < 0 ? "sig" : "exit", abs(r->status));
+        else printf(",%d,ok", r->rep + 1);
+        printf(",%.3f", r->wall_ns / 1e9);
+        if (r->have)
+            printf(",%.6f,%.6f,%ld,%ld,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+                   r->span, r->util, r->nswitch, r->npreempt, r->ta_mean, r->ta_p50, r->ta_p99,
+                   r->wt_p50, r->wt_p99, r->rt_p50, r->rt_p99, r->io_p50, r->io_p99, r->io_mb_s);
+        else
+            printf(",,,,,,,,,,,,,,\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option lopts[] = {
+        {"policy", required_argument, NULL, 'p'},
+        {"quantum-ms", required_argument, NULL, 'q'},
+        {"devices", required_argument, NULL, 'd'},
+        {"cpus", required_argument, NULL, 'c'},
+        {"workload", required_argument, NULL, 'L'},
+        {"apps", required_argument, NULL, 'n'},
+        {"disk-sched", required_argument, NULL, 'X'},
+        {"repeat", required_argument, NULL, 'r'},
+        {"timeout", required_argument, NULL, 't'},
+        {"keep", required_argument, NULL, 'k'},
+        {NULL, 0, NULL, 0},
+    };
+    static const char *const forbidden[] = {"--ctl", "--report-json", "--report-csv", "--trace", "--chrome",
+                                            "--stats"};
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int repeat = 1;
+    double timeout_s = 0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "j:", lopts, NULL)) != -1) {
+        switch (opt) {
+        case 'j':
+            jobs = atol(optarg);
+            if (jobs < 1) usage(argv[0]);
+            break;
+        case 'p': axis_parse(&axes[AX_POLICY], optarg); break;
+        case 'q': axis_parse(&axes[AX_QUANTUM], optarg); break;
+        case 'd': axis_parse(&axes[AX_DEVICES], optarg); break;
+        case 'c': axis_parse(&axes[AX_CPUS], optarg); break;
+        case 'L': axis_parse(&axes[AX_WORKLOAD], optarg); break;
+        case 'n': axis_parse(&axes[AX_APPS], optarg); break;
+        case 'X': axis_parse(&axes[AX_DISK], optarg); break;
+        case 'r':
+            repeat = atoi(optarg);
+            if (repeat < 1) usage(argv[0]);
+            break;
+        case 't':
+            timeout_s = atof(optarg);
+            if (timeout_s < 0) usage(argv[0]);
+            break;
+        case 'k':
+            snprintf(dir, sizeof(dir), "%s", optarg);
+            keep = 1;
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (jobs < 1) jobs = 1;
+    // o que sobra (depois de "--", ou num_apps) vai para o kernel_sim
+    extra = argv + optind;
+    nextra = argc - optind;
+    for (int k = 0; k < nextra; k++)
+        for (size_t f = 0; f < sizeof(forbidden) / sizeof(forbidden[0]); f++)
+            if (strncmp(extra[k], forbidden[f], strlen(forbidden[f])) == 0) {
+                fprintf(stderr, "sweep: %s não pode ser repassado (arquivo comum a todas as execuções)\n",
+                        forbidden[f]);
+                return 1;
+            }
+    if (access("./kernel_sim", X_OK) != 0) { perror("./kernel_sim"); return 1; }
+
+    if (keep) {
+        if (mkdir(dir, 0755) < 0 && errno != EEXIST) { perror(dir); return 1; }
+    } else {
+        snprintf(dir, sizeof(dir), "/tmp/sweep-XXXXXX");
+        if (!mkdtemp(dir)) { perror("mkdtemp"); return 1; }
+    }
+
+    // Combinações: contador de base mista sobre as dimensões, repetições
+    // por último
+    int total = repeat;
+    for (int k = 0; k < AX_N; k++) total *= axes[k].n ? axes[k].n : 1;
+    run_t *runs = calloc((size_t)total, sizeof(run_t));
+    int *active = calloc((size_t)jobs, sizeof(int));
+    if (!runs || !active) { perror("sweep"); return 1; }
+    for (int i = 0; i < total; i++) {
+        int x = i;
+        runs[i].rep = x % repeat;
+        x /= repeat;
+        for (int k = AX_N - 1; k >= 0; k--) {
+            int n = axes[k].n ? axes[k].n : 1;
+            runs[i].sel[k] = x % n;
+            x /= n;
+        }
+    }
+
+    // SIGCHLD (fim de uma simulação), SIGINT e SIGTERM numa espera só; os
+    // grupos das simulações não recebem o Ctrl-C do terminal, então o
+    // sweep os mata ao ser interrompido
+    sigset_t mask, oldmask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, &oldmask);
+
+    fprintf(stderr, "sweep: %d execuções, até %ld simultâneas; arquivos em %s\n", total, jobs, dir);
+    long long t_start = now_ns();
+    int next = 0, running = 0, done = 0, failed = 0;
+    while (done < total) {
+        while (running < jobs && next < total) {
+            run_start(&runs[next], next, &oldmask);
+            active[running++] = next++;
+        }
+
+        struct timespec ts = {0, 100000000L}; // revê os prazos do --timeout
+        int sig = sigtimedwait(&mask, NULL, &ts);
+        if (sig == SIGINT || sig == SIGTERM) {
+            for (int a = 0; a < running; a++) kill(-runs[active[a]].pid, SIGKILL);
+            while (wait(NULL) > 0) {}
+            fprintf(stderr, "sweep: interrompido (%d de %d execuções concluídas)\n", done, total);
+            return 130;
+        }
+
+        long long now = now_ns();
+        for (int a = 0; a < running; a++) {
+            run_t *r = &runs[active[a]];
+            siginfo_t si = {0};
+            // espia sem colher: o PID do kernel_sim (e do grupo) continua
+            // reservado enquanto o grupo é limpo
+            if (waitid(P_PID, (id_t)r->pid, &si, WEXITED | WNOHANG | WNOWAIT) < 0 || si.si_pid == 0) {
+                if (timeout_s > 0 && !r->timed_out && now - r->t0_ns > (long long)(timeout_s * 1e9)) {
+                    r->timed_out = 1;
+                    kill(-r->pid, SIGKILL);
+                }
+                continue;
+            }
+            kill(-r->pid, SIGKILL); // IC e apps que tenham sobrado no grupo
+            int st;
+            waitpid(r->pid, &st, 0);
+            int i = active[a];
+            r->wall_ns = now - r->t0_ns;
+            r->status = WIFEXITED(st) ? WEXITSTATUS(st) : -WTERMSIG(st);
+            if (!r->status) run_read(r, i);
+            int ok = !r->status && !r->timed_out && r->have;
+            if (!ok) failed++;
+            else if (!keep) run_clean(i);
+
+            char desc[256];
+            run_desc(r, desc, sizeof(desc));
+            done++;
+            if (ok)
+                fprintf(stderr, "[%d/%d] %s rep=%d: ok em %.2fs\n", done, total, desc, r->rep + 1, r->wall_ns / 1e9);
+            else
+                fprintf(stderr, "[%d/%d] %s rep=%d: %s (log em %s/run-%04d.log)\n", done, total, desc,
+                        r->rep + 1, r->timed_out ? "timeout" : "falhou", dir, i);
+            active[a--] = active[--running];
+        }
+    }
+
+    print_csv(runs, total);
+
+    // Melhor combinação pelo turnaround médio, por carga (cargas
+    // diferentes não se comparam)
+    fprintf(stderr, "sweep: %d execuções em %.1fs, %d falhas\n", total, (now_ns() - t_start) / 1e9, failed);
+    int nwl = axes[AX_WORKLOAD].n ? axes[AX_WORKLOAD].n : 1;
+    for (int w = 0; w < nwl; w++) {
+        int best = -1;
+        for (int i = 0; i < total; i++)
+            if (runs[i].sel[AX_WORKLOAD] == w && runs[i].have && !runs[i].timed_out
+                && (best < 0 || runs[i].ta_mean < runs[best].ta_mean)) best = i;
+        if (best < 0) continue;
+        char desc[256];
+        run_desc(&runs[best], desc, sizeof(desc));
+        fprintf(stderr, "sweep: menor turnaround médio: %s (%.2fs)\n", desc, runs[best].ta_mean);
+    }
+    if (!keep && failed == 0) rmdir(dir);
+    free(runs);
+    free(active);
+    return failed ? 2 : 0;
+}
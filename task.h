@@ -0,0 +1,150 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef TASK_H
+#define TASK_H
+
+/* Corrotinas em espaço de usuário para o modo --coro: cada app roda
+   como uma tarefa dentro do próprio kernel, com pilha própria, e devolve
+   o controle nos seus pontos de parada (task_yield). Trocar de tarefa
+   não envolve sinal nem troca de processo.
+
+   No x86-64 a troca é um task_swap de poucas instruções (salva os
+   registradores preservados pela ABI e troca o rsp). Nas demais
+   arquiteturas usa ucontext; o swapcontext da glibc também salva a
+   máscara de sinais, duas syscalls por ida e volta.
+
+   As pilhas vêm de uma arena única reservada com MAP_NORESERVE: só as
+   páginas tocadas ocupam memória (uma por tarefa viva) e task_release
+   devolve as de uma tarefa que terminou, então dá para ter centenas de
+   milhares de apps. Retomadas não se aninham: só o kernel retoma, e a
+   tarefa volta sempre para quem a retomou. Header-only, usado por
+   kernel_sim.c e bench.c. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#define TASK_STACK (16 * 1024)
+
+#if defined(__x86_64__)
+#define TASK_ASM 1
+#else
+#define TASK_ASM 0
+#include <ucontext.h>
+#endif
+
+typedef struct {
+#if TASK_ASM
+    void *sp;           // rsp salvo da tarefa
+    void *back;         // rsp salvo de quem retomou
+#else
+    ucontext_t ctx;
+    ucontext_t *back;
+#endif
+    char *stack;
+    int started;
+    int done;
+} task_t;
+
+#if TASK_ASM
+// task_swap(&salvo, destino): empilha rbp, rbx, r12-r15, guarda o rsp em
+// *salvo e continua na pilha `destino` (desempilha e retorna). Símbolo
+// local (.local): cada .c que inclui o header tem a sua cópia, sem
+// conflito na ligação de vários objetos
+void task_swap(void **save, void *to);
+__asm__(".text\n"
+        ".local task_swap\n"
+        ".type task_swap, @function\n"
+        "task_swap:\n"
+        "    pushq %rbp\n"
+        "    pushq %rbx\n"
+        "    pushq %r12\n"
+        "    pushq %r13\n"
+        "    pushq %r14\n"
+        "    pushq %r15\n"
+        "    movq %rsp, (%rdi)\n"
+        "    movq %rsi, %rsp\n"
+        "    popq %r15\n"
+        "    popq %r14\n"
+        "    popq %r13\n"
+        "    popq %r12\n"
+        "    popq %rbx\n"
+        "    popq %rbp\n"
+        "    ret\n"
+        ".size task_swap, .-task_swap\n");
+#endif
+
+// Reserva as pilhas de n tarefas (sem ocupar memória ainda); NULL em erro
+static inline char *task_arena(size_t n)
+{
+    void *a = mmap(NULL, n * TASK_STACK, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return a == MAP_FAILED ? NULL : a;
+}
+
+// Prepara a tarefa para rodar fn na pilha dada; fn termina com task_exit
+static inline void task_init(task_t *t, char *stack, void (*fn)(void))
+{
+    t->stack = stack;
+    t->started = t->done = 0;
+#if TASK_ASM
+    // quadro inicial para o task_swap: seis registradores zerados e o
+    // endereço de fn como retorno; na entrada, rsp + 8 alinhado em 16
+    uintptr_t top = ((uintptr_t)stack + TASK_STACK) & ~(uintptr_t)15;
+    void **sp = (void **)top;
+    *--sp = NULL;               // "retorno" de fn (não retorna)
+    *--sp = (void *)fn;
+    for (int i = 0; i < 6; i++) *--sp = NULL;
+    t->sp = sp;
+#else
+    getcontext(&t->ctx);
+    t->ctx.uc_stack.ss_sp = stack;
+    t->ctx.uc_stack.ss_size = TASK_STACK;
+    t->ctx.uc_link = NULL;
+    makecontext(&t->ctx, fn, 0);
+#endif
+}
+
+// Kernel: roda a tarefa até o próximo task_yield (ou task_exit)
+static inline void task_resume(task_t *t)
+{
+    t->started = 1;
+#if TASK_ASM
+    task_swap(&t->back, t->sp);
+#else
+    ucontext_t here;
+    t->back = &here;
+    swapcontext(&here, &t->ctx);
+#endif
+}
+
+// Tarefa: devolve o controle a quem a retomou
+static inline void task_yield(task_t *t)
+{
+#if TASK_ASM
+    task_swap(&t->sp, t->back);
+#else
+    swapcontext(&t->ctx, t->back);
+#endif
+}
+
+// Tarefa: termina; não volta mais
+static inline void task_exit(task_t *t)
+{
+    t->done = 1;
+#if TASK_ASM
+    task_swap(&t->sp, t->back);
+#else
+    setcontext(t->back);
+#endif
+}
+
+// Kernel: devolve as páginas da pilha de uma tarefa terminada
+static inline void task_release(task_t *t)
+{
+    if (t->stack) madvise(t->stack, TASK_STACK, MADV_DONTNEED);
+    t->stack = NULL;
+}
+
+#endif
@@ -0,0 +1,281 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/* Trace binário de eventos do kernel (--trace <arquivo>).
+   Cada transição vira um registro fixo de 48 bytes (instante em ns desde
+   o boot, tipo, núcleo, PID, argumentos e tamanhos das filas) gravado num
+   anel pré-alocado. Uma thread escritora drena o anel para o arquivo em
+   blocos grandes, então o loop do escalonador não faz printf nem write
+   por evento.
+
+   O mesmo trace_render() formata o log em texto ao vivo (sem --trace) e
+   no ktrace.c, que reconstrói o log a partir do arquivo.
+
+   Arquivo: trace_hdr_t seguido dos registros. Header-only, usado por
+   kernel_sim.c e ktrace.c. */
+
+#include "common.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+
+#define TRACE_MAGIC "KSIMTRC1"
+
+/* ====== códigos ANSI (os mesmos do log do kernel) ====== */
+#define T_RST "\x1b[0m"
+#define T_IRQ "\x1b[36m"
+#define T_SCH "\x1b[33m"
+#define T_IO  "\x1b[35m"
+#define T_APP "\x1b[32m"
+#define T_ERR "\x1b[31m"
+
+enum {
+    TR_SPAWN = 1,      // pid; nome em x/y
+    TR_DISPATCH,       // pid, cpu; a=PC restaurado, b=última syscall (-1/0/1)
+    TR_IDLE,           // fila vazia
+    TR_PREEMPT,        // pid, cpu
+    TR_STEAL,          // pid, cpu=destino; a=origem
+    TR_IO_START,       // pid; a=dispositivo, b=juntados, x=endereço (-1 sem disco), y=serviço ns
+    TR_IRQ1,           // a=dispositivo, b=req_id
+    TR_IRQ1_STALE,     // a=dispositivo, b=req_id
+    TR_IO_DONE,        // pid; x=fila ns, y=serviço ns, a=entrega us
+    TR_SYSCALL,        // pid; a=0 READ / 1 WRITE
+    TR_BLOCK,          // pid; a=PC, b=RW
+    TR_PC,             // pid; a=PC
+    TR_FINISHED,       // pid
+    TR_IRQ0,           // cpu (preempção)
+    TR_IRQ0_KEEP,      // pid, cpu (política mantém o atual)
+    TR_IRQ0_ONLY,      // cpu (único pronto continua)
+    TR_NUDGE,          // pid; a=ticks sem progresso
+    TR_AIO_SUBMIT,     // pid; a=0 READ / 1 WRITE, b=em voo
+    TR_AIO_WAIT,       // pid; a=alvo de concluídos, b=concluídos
+    TR_AIO_DONE,       // pid; como TR_IO_DONE, b=em voo restantes
+    TR_AIO_WAKE,       // pid; a=concluídos, b=em voo
+};
+
+typedef struct {
+    int64_t  t_ns;     // desde o boot (relógio do kernel)
+    uint16_t type;
+    int16_t  cpu;
+    int32_t  pid;
+    int32_t  a, b;
+    uint32_t rq;       // prontos em todos os núcleos
+    uint32_t ioq;      // pedidos de I/O em fila ou em serviço
+    int64_t  x, y;
+} trace_rec_t;
+
+typedef struct {
+    char     magic[8];
+    uint32_t rec_size;
+    int32_t  ncpus;
+    int32_t  log_ms;   // timestamps com milissegundos
+    int32_t  des;
+    char     policy[16];
+    uint64_t dropped;  // registros descartados com o anel cheio (no fim)
+} trace_hdr_t;
+
+/* ====== Formatação (log em texto) ====== */
+static inline void trace_render(FILE *f, const trace_hdr_t *h, const trace_rec_t *r, const char *name)
+{
+    char tag[16] = "";
+    if (h->ncpus > 1 && r->cpu >= 0) snprintf(tag, sizeof(tag), " @CPU%d", r->cpu + 1);
+    if (h->log_ms) fprintf(f, "[%8.3fs] ", r->t_ns / 1e9);
+    else fprintf(f, "[%3lds] ", (long)(r->t_ns / 1000000000LL));
+
+    const char *rw = r->b == -1 ? "-" : (r->b ? "W" : "R");
+    switch (r->type) {
+    case TR_SPAWN:
+        fprintf(f, T_APP "SPAWN     ++ %-3s (pid=%d) adicionado à fila de prontos" T_RST "\n", name, r->pid);
+        break;
+    case TR_DISPATCH:
+        fprintf(f, T_SCH "DISPATCH  -> %-3s (pid=%d) [restore PC=%d, RW=%s]%s" T_RST "\n",
+                name, r->pid, r->a, rw, tag);
+        break;
+    case TR_IDLE:
+        fprintf(f, T_SCH "DISPATCH  (fila vazia) — aguardando próximo evento" T_RST "\n");
+        break;
+    case TR_PREEMPT:
+        fprintf(f, T_SCH "PREEMPT   <- %-3s (volta à fila de prontos)%s" T_RST "\n", name, tag);
+        break;
+    case TR_STEAL:
+        fprintf(f, T_SCH "STEAL     <> %-3s de CPU%d para CPU%d" T_RST "\n", name, r->a + 1, r->cpu + 1);
+        break;
+    case TR_IO_START:
+        if (r->x < 0) {
+            fprintf(f, T_IO "IO-START  >> %-3s (pid=%d) — D%d ocupado" T_RST "\n", name, r->pid, r->a + 1);
+            break;
+        }
+        fprintf(f, T_IO "IO-START  >> %-3s (pid=%d) — D%d ocupado [@%.1fMB, +%d juntados, serviço %.2fms]" T_RST "\n",
+                name, r->pid, r->a + 1, r->x / 1048576.0, r->b, r->y / 1e6);
+        break;
+    case TR_IRQ1:
+        fprintf(f, T_IRQ "IRQ1      ** D%d sinaliza término de I/O (req=%u)" T_RST "\n", r->a + 1, (unsigned)r->b);
+        break;
+    case TR_IRQ1_STALE:
+        fprintf(f, T_ERR "IRQ1      ?? req=%u não está em serviço em D%d; ignorado" T_RST "\n",
+                (unsigned)r->b, r->a + 1);
+        break;
+    case TR_IO_DONE:
+        fprintf(f, T_IO "IO-DONE   << %-3s liberado; volta à fila de prontos"
+                " [lat=%.1fms: fila %.1f + serviço %.1f + entrega %.3f]" T_RST "\n",
+                name, (r->x + r->y + r->a * 1000LL) / 1e6, r->x / 1e6, r->y / 1e6, r->a / 1e3);
+        break;
+    case TR_SYSCALL:
+        fprintf(f, T_IO "SYSCALL   !! %-3s pede I/O (%s)" T_RST "\n", name, r->a ? "WRITE" : "READ");
+        break;
+    case TR_BLOCK:
+        fprintf(f, T_IO "BLOCK     .. %-3s bloqueado por I/O [ctx: PC=%d, RW=%s]" T_RST "\n", name, r->a, rw);
+        break;
+    case TR_PC:
+        fprintf(f, T_APP "PC        :: %-3s -> %d" T_RST "\n", name, r->a);
+        break;
+    case TR_FINISHED:
+        fprintf(f, T_APP "FINISHED  xx %-3s (pid=%d)" T_RST "\n", name, r->pid);
+        break;
+    case TR_IRQ0:
+        fprintf(f, T_IRQ "IRQ0      ** time-slice encerrado%s" T_RST "\n", tag);
+        break;
+    case TR_IRQ0_KEEP:
+        fprintf(f, T_IRQ "IRQ0      ** time-slice encerrado — %s continua (%s)%s" T_RST "\n",
+                name, h->policy, tag);
+        break;
+    case TR_IRQ0_ONLY:
+        fprintf(f, T_IRQ "IRQ0      ** time-slice encerrado — único pronto continua%s" T_RST "\n", tag);
+        break;
+    case TR_NUDGE:
+        fprintf(f, T_ERR "NUDGE     !! sem progresso (%d ticks) — reativando %s" T_RST "\n", r->a, name);
+        break;
+    case TR_AIO_SUBMIT:
+        fprintf(f, T_IO "AIO       >> %-3s submete I/O (%s) e segue [%d em voo]%s" T_RST "\n",
+                name, r->a ? "WRITE" : "READ", r->b, tag);
+        break;
+    case TR_AIO_WAIT:
+        fprintf(f, T_IO "AIO-WAIT  .. %-3s espera %d concluídos (%d até agora)%s" T_RST "\n", name, r->a, r->b, tag);
+        break;
+    case TR_AIO_DONE:
+        fprintf(f, T_IO "AIO-DONE  << %-3s pedido assíncrono concluído [%d em voo]"
+                " [lat=%.1fms: fila %.1f + serviço %.1f + entrega %.3f]" T_RST "\n",
+                name, r->b, (r->x + r->y + r->a * 1000LL) / 1e6, r->x / 1e6, r->y / 1e6, r->a / 1e3);
+        break;
+    case TR_AIO_WAKE:
+        fprintf(f, T_IO "AIO-WAKE  << %-3s liberado (%d concluídos); volta à fila de prontos" T_RST "\n", name, r->a);
+        break;
+    default:
+        fprintf(f, "??        tipo %u (pid=%d)\n", r->type, r->pid);
+    }
+}
+
+/* ====== Anel + thread escritora ====== */
+// Produtor único (loop do kernel), consumidor único (escritora).
+typedef struct {
+    trace_rec_t *v;
+    uint32_t mask;
+    _Atomic uint32_t head;      // próximo a gravar (escritora)
+    _Atomic uint32_t tail;      // próximo a publicar (kernel)
+    _Atomic int stop;
+    _Atomic int sleeping;       // escritora esperando na condição
+    uint64_t dropped;
+    int fd;
+    trace_hdr_t hdr;
+    pthread_t th;
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+} tracer_t;
+
+static inline void *trace_writer(void *arg)
+{
+    tracer_t *t = arg;
+    for (;;) {
+        uint32_t head = atomic_load_explicit(&t->head, memory_order_relaxed);
+        uint32_t tail = atomic_load_explicit(&t->tail, memory_order_acquire);
+        if (head == tail) {
+            if (atomic_load(&t->stop)) break;
+            // espera o anel encher um pouco (ou 10ms): escreve em blocos
+            pthread_mutex_lock(&t->mu);
+            atomic_store(&t->sleeping, 1);
+            if (atomic_load(&t->tail) == head && !atomic_load(&t->stop)) {
+                struct timespec dl;
+                clock_gettime(CLOCK_REALTIME, &dl);
+                dl.tv_nsec += 10000000L;
+                if (dl.tv_nsec >= 1000000000L) { dl.tv_sec++; dl.tv_nsec -= 1000000000L; }
+                pthread_cond_timedwait(&t->cv, &t->mu, &dl);
+            }
+            atomic_store(&t->sleeping, 0);
+            pthread_mutex_unlock(&t->mu);
+            continue;
+        }
+        // trecho contíguo até o fim do vetor
+        uint32_t i = head & t->mask;
+        uint32_t n = tail - head;
+        if (n > t->mask + 1 - i) n = t->mask + 1 - i;
+        ssize_t w = write(t->fd, &t->v[i], (size_t)n * sizeof(trace_rec_t));
+        if (w < 0) { perror("trace write"); w = (ssize_t)n * (ssize_t)sizeof(trace_rec_t); }
+        atomic_store_explicit(&t->head, head + (uint32_t)(w / (ssize_t)sizeof(trace_rec_t)),
+                              memory_order_release);
+    }
+    return NULL;
+}
+
+// Abre o arquivo, grava o cabeçalho e inicia a escritora; 0 em erro
+static inline int trace_open(tracer_t *t, const char *path, uint32_t cap, const trace_hdr_t *hdr)
+{
+    memset(t, 0, sizeof(*t));
+    uint32_t c = 1024;
+    while (c < cap) c <<= 1;
+    t->v = calloc(c, sizeof(trace_rec_t));
+    t->mask = c - 1;
+    t->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (!t->v || t->fd < 0) return 0;
+    t->hdr = *hdr;
+    memcpy(t->hdr.magic, TRACE_MAGIC, 8);
+    t->hdr.rec_size = sizeof(trace_rec_t);
+    if (write(t->fd, &t->hdr, sizeof(t->hdr)) != sizeof(t->hdr)) return 0;
+    pthread_mutex_init(&t->mu, NULL);
+    pthread_cond_init(&t->cv, NULL);
+    return pthread_create(&t->th, NULL, trace_writer, t) == 0;
+}
+
+// Publica um registro; com o anel cheio descarta (block=0) ou espera
+// a escritora (block=1, usado no --des, onde não há tempo real a perder)
+static inline void trace_push(tracer_t *t, const trace_rec_t *r, int block)
+{
+    uint32_t tail = atomic_load_explicit(&t->tail, memory_order_relaxed);
+    while (tail - atomic_load_explicit(&t->head, memory_order_acquire) > t->mask) {
+        if (!block) { t->dropped++; return; }
+        sched_yield();
+    }
+    t->v[tail & t->mask] = *r;
+    atomic_store_explicit(&t->tail, tail + 1, memory_order_release);
+    // acorda a escritora só quando há um bloco que compense
+    if (atomic_load(&t->sleeping) && (tail + 1 - atomic_load(&t->head)) >= (t->mask + 1) / 4) {
+        pthread_mutex_lock(&t->mu);
+        pthread_cond_signal(&t->cv);
+        pthread_mutex_unlock(&t->mu);
+    }
+}
+
+// Drena tudo, anota os descartes no cabeçalho e fecha
+static inline void trace_close(tracer_t *t)
+{
+    pthread_mutex_lock(&t->mu);
+    atomic_store(&t->stop, 1);
+    pthread_cond_signal(&t->cv);
+    pthread_mutex_unlock(&t->mu);
+    pthread_join(t->th, NULL);
+    t->hdr.dropped = t->dropped;
+    if (pwrite(t->fd, &t->hdr, sizeof(t->hdr), 0) != sizeof(t->hdr)) perror("trace hdr");
+    close(t->fd);
+    free(t->v);
+}
+
+#endif
@@ -0,0 +1,233 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+// Gera cargas sintéticas no formato de workload.h (kernel_sim --workload).
+// Uso: ./wlgen [--seed S] [--mix cpu=40,io=30,bursty=20,heavy=10]
+//              [--rate R] [--devices N] [--pcs P] [--addr seq|rand]
+//              [--async N] <num_apps> > carga.txt
+//   --mix      proporção de cada classe de app (pesos relativos)
+//   --rate     chegadas por segundo (processo de Poisson); 0 = todos no boot
+//   --devices  sorteia o dispositivo de cada I/O em 1..N (0 = o kernel escolhe)
+//   --pcs      tamanho médio de um app em PCs (padrão 15, como no enunciado)
+//   --addr     endereço dos I/Os (kernel_sim --disk-sched): seq = fluxo
+//              sequencial de cada app (padrão, sem endereço no passo);
+//              rand = sorteado no disco todo
+//   --async    I/Os assíncronos (aread/awrite, kaio.h) com até N em voo:
+//              antes de submeter com N em voo, espera um (wait:N-1); a
+//              mesma semente gera a mesma carga, só sem bloquear no I/O
+//
+// Classes:
+//   cpu     (C) rajadas longas de CPU, no máximo um I/O
+//   io      (I) muitos I/Os pequenos separados por 1-2 PCs
+//   bursty  (B) fases: rajada de CPU seguida de vários I/Os em sequência
+//   heavy   (H) rajadas e tamanhos de I/O com cauda pesada (Pareto)
+//
+// Usa a libm (pow, log): compilar com -lm (gcc wlgen.c -o wlgen -lm).
+
+#include "common.h"
+#include "workload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+
+enum { K_CPU, K_IO, K_BURSTY, K_HEAVY, K_N };
+static const char *const kind_name[K_N] = {"cpu", "io", "bursty", "heavy"};
+static const char kind_tag[K_N] = {'C', 'I', 'B', 'H'};
+
+static int ndev = 0;
+static int pcs = 15;
+static int addr_rand = 0;
+static int async_depth = 0;   // --async: pedidos em voo por app (0 = bloqueante)
+static int inflight = 0;      // pedidos assíncronos em voo no app atual
+
+// xorshift: a mesma semente gera a mesma carga
+static unsigned long long rng_state = 88172645463325252ULL;
+static unsigned long long rnd(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+static double urand(void) { return (rnd() >> 11) * (1.0 / 9007199254740992.0); }
+// Inteiro em [lo, hi]; hi < lo vale como hi = lo
+static int irand(int lo, int hi)
+{
+    if (hi < lo) hi = lo;
+    return lo + (int)(rnd() % (unsigned long long)(hi - lo + 1));
+}
+
+// Pareto(alpha, xmin), truncada em cap
+static double pareto(double alpha, double xmin, double cap)
+{
+    double x = xmin / pow(1.0 - urand(), 1.0 / alpha);
+    return x > cap ? cap : x;
+}
+
+static void put_cpu(int n)
+{
+    printf(" cpu:%d", n < 1 ? 1 : n);
+}
+
+static void put_io(long size)
+{
+    if (async_depth > 0) {
+        if (inflight == async_depth) printf(" wait:%d", --inflight);
+        inflight++;
+    }
+    printf(" %s%s", async_depth > 0 ? "a" : "", urand() < 0.5 ? "read" : "write");
+    int d = ndev > 0 ? irand(1, ndev) : 0;
+    if (size == WL_IO_UNIT && d == 0 && !addr_rand) return;
+    printf(":%d", d);
+    if (size != WL_IO_UNIT || addr_rand) {
+        if (size % (1024 * 1024) == 0) printf(":%ldm", size / (1024 * 1024));
+        else if (size % 1024 == 0) printf(":%ldk", size / 1024);
+        else printf(":%ld", size);
+    }
+    if (addr_rand) printf(":%lldk", (long long)(rnd() % (unsigned long long)((WL_DISK_BYTES - size) / 4096)) * 4);
+}
+
+static void gen_app(int kind)
+{
+    inflight = 0;
+    switch (kind) {
+    case K_CPU: {
+        int total = irand(pcs, 2 * pcs);
+        if (total < 2 || urand() < 0.5) {   // 1 PC não divide em volta do I/O
+            put_cpu(total);
+        } else {
+            int a = irand(1, total - 1);
+            put_cpu(a);
+            put_io(WL_IO_UNIT);
+            put_cpu(total - a);
+        }
+        break;
+    }
+    case K_IO: {
+        int nio = irand(pcs / 3 > 2 ? pcs / 3 : 2, pcs * 2 / 3 > 3 ? pcs * 2 / 3 : 3);
+        for (int k = 0; k < nio; k++) {
+            put_cpu(irand(1, 2));
+            put_io(4096L << irand(0, 2));
+        }
+        put_cpu(1);
+        break;
+    }
+    case K_BURSTY: {
+        int phases = irand(2, 4);
+        for (int k = 0; k < phases; k++) {
+            put_cpu(irand(pcs / 3 > 1 ? pcs / 3 : 1, pcs * 2 / 3 > 2 ? pcs * 2 / 3 : 2));
+            for (int j = irand(2, 4); j > 0; j--) put_io(4096L << irand(0, 4));
+        }
+        put_cpu(1);
+        break;
+    }
+    case K_HEAVY: {
+        // média da Pareto(1.5, xmin) = 3*xmin: rajadas em torno de pcs/3 ao todo
+        int steps = irand(2, 5);
+        double xmin = pcs / 9.0 < 1 ? 1 : pcs / 9.0;
+        for (int k = 0; k < steps; k++) {
+            put_cpu((int)pareto(1.5, xmin, 50.0 * pcs));
+            long size = (long)pareto(1.2, 4096, 64.0 * 1024 * 1024) / 4096 * 4096;
+            if (k + 1 < steps) put_io(size);
+        }
+        break;
+    }
+    }
+    putchar('\n');
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Uso: %s [--seed S] [--mix cpu=40,io=30,bursty=20,heavy=10] [--rate R]\n"
+            "          [--devices N] [--pcs P] [--addr seq|rand] [--async N] <num_apps>\n", argv0);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option lopts[] = {
+        {"seed", required_argument, NULL, 's'},
+        {"mix", required_argument, NULL, 'm'},
+        {"rate", required_argument, NULL, 'r'},
+        {"devices", required_argument, NULL, 'd'},
+        {"pcs", required_argument, NULL, 'p'},
+        {"addr", required_argument, NULL, 'a'},
+        {"async", required_argument, NULL, 'A'},
+        {NULL, 0, NULL, 0},
+    };
+    double mix[K_N] = {40, 30, 20, 10};
+    double rate = 0;
+    unsigned long long seed = 1;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", lopts, NULL)) != -1) {
+        switch (opt) {
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'm': {
+            memset(mix, 0, sizeof(mix));
+            char *s = strdup(optarg), *save = NULL;
+            for (char *t = strtok_r(s, ",", &save); t; t = strtok_r(NULL, ",", &save)) {
+                char *eq = strchr(t, '=');
+                int k;
+                for (k = 0; k < K_N; k++)
+                    if (eq && strncmp(t, kind_name[k], (size_t)(eq - t)) == 0
+                        && strlen(kind_name[k]) == (size_t)(eq - t)) break;
+                if (k == K_N || atof(eq + 1) < 0) usage(argv[0]);
+                mix[k] = atof(eq + 1);
+            }
+            free(s);
+            break;
+        }
+        case 'r':
+            rate = atof(optarg);
+            if (rate < 0) usage(argv[0]);
+            break;
+        case 'd':
+            ndev = atoi(optarg);
+            if (ndev < 0) usage(argv[0]);
+            break;
+        case 'p':
+            pcs = atoi(optarg);
+            if (pcs < 1) usage(argv[0]);
+            break;
+        case 'a':
+            if (strcmp(optarg, "rand") == 0) addr_rand = 1;
+            else if (strcmp(optarg, "seq") != 0) usage(argv[0]);
+            break;
+        case 'A':
+            async_depth = atoi(optarg);
+            if (async_depth < 1) usage(argv[0]);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (optind >= argc) usage(argv[0]);
+    int n = atoi(argv[optind]);
+    double total = 0;
+    for (int k = 0; k < K_N; k++) total += mix[k];
+    if (n < 1 || total <= 0) usage(argv[0]);
+
+    rng_state ^= seed * 0x9E3779B97F4A7C15ULL;
+    if (!rng_state) rng_state = 1;
+
+    printf("# wlgen --seed %llu --mix cpu=%g,io=%g,bursty=%g,heavy=%g --rate %g --devices %d --pcs %d%s",
+           seed, mix[0], mix[1], mix[2], mix[3], rate, ndev, pcs, addr_rand ? " --addr rand" : "");
+    if (async_depth) printf(" --async %d", async_depth);
+    printf(" %d\n", n);
+    printf("# nome chegada_ms passos\n");
+    double t_ms = 0;
+    for (int i = 0; i < n; i++) {
+        double u = urand() * total;
+        int kind = 0;
+        while (kind < K_N - 1 && u >= mix[kind]) u -= mix[kind++];
+        if (rate > 0 && i > 0) t_ms += -log(1.0 - urand()) / rate * 1000.0;
+        printf("%c%d %.3f", kind_tag[kind], i + 1, t_ms);
+        gen_app(kind);
+    }
+    return 0;
+}
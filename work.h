@@ -0,0 +1,92 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef WORK_H
+#define WORK_H
+
+/* Trabalho de um PC dos apps (--work no kernel):
+     sleep  dorme work_ns (padrão, o do enunciado): o app não usa CPU e a
+            disputa pela CPU real não aparece
+     spin   conta de inteiros que não sai dos registradores
+     mem    percorre um buffer de WORK_MEM_BYTES (maior que a cache) lendo
+            e escrevendo uma linha de cache por iteração: limitado pela
+            banda de memória
+   spin e mem fazem uma quantidade fixa de iterações por PC, calibrada
+   pelo kernel no boot (work_calibrate) para durar work_ns de CPU com a
+   máquina livre; com disputa, o mesmo PC demora mais no relógio de
+   parede. O app faz o PC em pedaços de WORK_CHUNK iterações, para
+   obedecer ao portão (park.h) no meio. Header-only, usado por
+   kernel_sim.c e app.c. */
+
+#include "common.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum { WORK_SLEEP = 0, WORK_SPIN, WORK_MEM };
+static const char *const work_names[] = {"sleep", "spin", "mem"};
+
+#define WORK_MEM_BYTES (16 << 20)
+#define WORK_LINE      64
+#define WORK_CHUNK     (1 << 14)
+#define WORK_CALIB_NS  20000000LL   // CPU mínima medida na calibração
+
+typedef struct {
+    int mode;
+    uint64_t x;               // spin: estado (e soma do mem)
+    unsigned char *buf;       // mem: buffer, alocado no primeiro uso
+    size_t pos;
+} work_t;
+
+static volatile uint64_t work_sink;   // o resultado "é usado": o laço fica
+
+// n iterações do trabalho; 0 se faltou memória (mem)
+static inline int work_run(work_t *w, long long n)
+{
+    if (w->mode == WORK_SPIN) {
+        uint64_t x = w->x | 1;
+        for (long long i = 0; i < n; i++) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            x ^= x >> 29;
+        }
+        w->x = work_sink = x;
+        return 1;
+    }
+    if (!w->buf && !(w->buf = calloc(1, WORK_MEM_BYTES))) return 0;
+    uint64_t s = w->x;
+    for (long long i = 0; i < n; i++) {
+        s += w->buf[w->pos]++;
+        w->pos += WORK_LINE;
+        if (w->pos >= WORK_MEM_BYTES) w->pos = 0;
+    }
+    w->x = work_sink = s;
+    return 1;
+}
+
+static inline long long work_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Iterações do modo `mode` que custam ns de CPU nesta máquina (kernel,
+// no boot): dobra a amostra até medir WORK_CALIB_NS. 0 em erro
+static inline long long work_calibrate(int mode, long long ns)
+{
+    work_t w = {.mode = mode};
+    if (!work_run(&w, WORK_MEM_BYTES / WORK_LINE)) return 0;   // aquece o buffer
+    long long n = WORK_CHUNK, dt = 0;
+    for (;;) {
+        long long t0 = work_cpu_ns();
+        work_run(&w, n);
+        dt = work_cpu_ns() - t0;
+        if (dt >= WORK_CALIB_NS) break;
+        n *= 2;
+    }
+    free(w.buf);
+    long long iters = (long long)((double)n * ns / dt);
+    return iters > 0 ? iters : 1;
+}
+
+#endif
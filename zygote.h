@@ -0,0 +1,92 @@
+// Livian Essvein 2211667
+// Giovana Nogueira 2220372
+
+#ifndef ZYGOTE_H
+#define ZYGOTE_H
+
+/* Reserva de apps pré-criados (--spawn pool). O kernel cria alguns ./app
+   de antemão com --zygote: cada um já fez fork+exec e dorme num futex da
+   sua vaga, numa área compartilhada (memfd herdado no exec). Admitir um
+   app passa a ser escrever nome, índice e programa na vaga e acordar o
+   zigoto; o custo do fork+exec sai do caminho da chegada e vai para o
+   reabastecimento da reserva, feito aos poucos entre as rodadas do loop.
+
+   Estados da vaga (mesmo protocolo dos portões em park.h):
+     ZYG_IDLE   sem tarefa; o zigoto ainda não dormiu
+     ZYG_WAIT   zigoto dormindo no futex: quem atribuir precisa acordar
+     ZYG_GO     tarefa escrita pelo kernel
+
+   Programas maiores que ZYG_PROG_MAX não cabem na vaga: o kernel cria o
+   app direto (posix_spawn). Header-only, usado por kernel_sim.c, app.c e
+   bench.c. */
+
+#include "common.h"
+#include "park.h"
+#include <stdio.h>
+#include <string.h>
+
+enum { ZYG_IDLE = 0, ZYG_WAIT = 1, ZYG_GO = 2 };
+
+#define ZYG_SLOT_BYTES 512
+#define ZYG_PROG_MAX   (ZYG_SLOT_BYTES - 8 - MAX_NAME)
+
+typedef struct {
+    _Atomic uint32_t state;
+    int  idx;                  // índice do app (programa fixo se prog vazio)
+    char name[MAX_NAME];
+    char prog[ZYG_PROG_MAX];   // passos (workload.h), terminados em '\0'
+} zygslot_t;
+
+// Cria a área com n vagas vazias (kernel); NULL em erro
+static inline zygslot_t *zyg_create(int n, int *fd_out)
+{
+    size_t bytes = (size_t)n * sizeof(zygslot_t);
+    int fd = memfd_create("ksim-zygote", 0);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, (off_t)bytes) < 0) { close(fd); return NULL; }
+    zygslot_t *v = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (v == MAP_FAILED) { close(fd); return NULL; }
+    *fd_out = fd;
+    return v;
+}
+
+// Mapeia a área herdada e devolve a vaga `slot` (apps)
+static inline zygslot_t *zyg_attach(int fd, int slot)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < (size_t)(slot + 1) * sizeof(zygslot_t))
+        return NULL;
+    zygslot_t *v = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return v == MAP_FAILED ? NULL : &v[slot];
+}
+
+// Kernel: esvazia a vaga antes de entregá-la a um novo zigoto
+static inline void zyg_reset(zygslot_t *z)
+{
+    atomic_store(&z->state, ZYG_IDLE);
+}
+
+// Kernel: entrega a tarefa e acorda o zigoto; 0 se o programa não cabe
+static inline int zyg_assign(zygslot_t *z, int idx, const char *name, const char *prog)
+{
+    size_t len = prog ? strlen(prog) : 0;
+    if (len >= ZYG_PROG_MAX) return 0;
+    z->idx = idx;
+    snprintf(z->name, sizeof(z->name), "%.*s", MAX_NAME - 1, name);
+    memcpy(z->prog, prog ? prog : "", len + 1);
+    if (atomic_exchange(&z->state, ZYG_GO) == ZYG_WAIT) park_futex(&z->state, FUTEX_WAKE, 1);
+    return 1;
+}
+
+// App: dorme até o kernel entregar uma tarefa
+static inline void zyg_wait(zygslot_t *z)
+{
+    for (;;) {
+        uint32_t v = atomic_load(&z->state);
+        if (v == ZYG_GO) return;
+        if (v == ZYG_IDLE && !atomic_compare_exchange_strong(&z->state, &v, ZYG_WAIT)) continue;
+        park_futex(&z->state, FUTEX_WAIT, ZYG_WAIT);
+    }
+}
+
+#endif